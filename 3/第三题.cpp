@@ -1,7 +1,36 @@
 #include <iostream>
 #include <vector>
 #include <random>
-#include <iomanip>  // ڸʽ
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define TRAJ_HAVE_MMAP 1
+#endif
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 struct Point2D {
     double x;
@@ -74,12 +103,4007 @@ std::vector<Point2D> simulateWithProcessNoise(
     return positions;
 }
 
-int main()
+// ɲ˶ģͣģͺ͹Ǳڲͣ
+// simulateMotion<ģ, > ÿ϶ʵΪû
+struct MotionState {
+    Point2D pos{0.0, 0.0};
+    Point2D vel{0.0, 0.0};
+    Point2D acc{0.0, 0.0};   // ٶģʹ
+    double turn_rate = 0.0;  // Эתģʹã/룩
+};
+
+// ٣CV
+struct ConstantVelocityModel {
+    static void step(MotionState& s, double dt)
+    {
+        s.pos.x += s.vel.x * dt;
+        s.pos.y += s.vel.y * dt;
+    }
+};
+
+// ٶȣCAλðȷĶʽ
+struct ConstantAccelerationModel {
+    static void step(MotionState& s, double dt)
+    {
+        s.pos.x += s.vel.x * dt + 0.5 * s.acc.x * dt * dt;
+        s.pos.y += s.vel.y * dt + 0.5 * s.acc.y * dt * dt;
+        s.vel.x += s.acc.x * dt;
+        s.vel.y += s.acc.y * dt;
+    }
+};
+
+// Эת䣨CTRVʲ䣬ٶȷ turn_rate תʽ
+struct CoordinatedTurnModel {
+    static void step(MotionState& s, double dt)
+    {
+        const double w = s.turn_rate;
+        if (std::fabs(w) < 1e-9) {
+            ConstantVelocityModel::step(s, dt);
+            return;
+        }
+        const double c = std::cos(w * dt);
+        const double sn = std::sin(w * dt);
+        s.pos.x += (s.vel.x * sn - s.vel.y * (1.0 - c)) / w;
+        s.pos.y += (s.vel.y * sn + s.vel.x * (1.0 - c)) / w;
+        const double vx = s.vel.x * c - s.vel.y * sn;
+        const double vy = s.vel.x * sn + s.vel.y * c;
+        s.vel.x = vx;
+        s.vel.y = vy;
+    }
+};
+
+// ޹
+struct NoProcessNoise {
+    void perturb(MotionState&) {}
+};
+
+// ٶߣ simulateWithProcessNoise ͬÿȸٶȵٻλ
+struct VelocityRandomWalk {
+    std::default_random_engine generator;
+    std::normal_distribution<double> noise;
+
+    explicit VelocityRandomWalk(double stddev, unsigned seed = std::random_device{}())
+        : generator(seed), noise(0.0, stddev) {}
+
+    void perturb(MotionState& s)
+    {
+        s.vel.x += noise(generator);
+        s.vel.y += noise(generator);
+    }
+};
+
+template <typename Model, typename Noise = NoProcessNoise>
+std::vector<Point2D> simulateMotion(
+    double total_time, double dt, MotionState state, Noise noise = Noise{})
+{
+    int steps = static_cast<int>(total_time / dt);
+    std::vector<Point2D> positions;
+    positions.reserve(steps + 1);
+    positions.push_back(state.pos);
+
+    for (int i = 1; i <= steps; ++i) {
+        noise.perturb(state);
+        Model::step(state, dt);
+        positions.push_back(state.pos);
+    }
+    return positions;
+}
+
+// ¼棺ע롢/ָǴʱ¼
+// ȶаʱ˳ȡ¼ֵ֮˶ģһλֵλʱûп
+struct SensorConfig {
+    double rate_hz = 100.0;             // Ʋ
+    double jitter_stddev = 0.0;         // ʱ̶룩
+    double noise_stddev = 0.5;          // ׼
+    double mean_time_to_dropout = 0.0;  // ƽ޹ʱ䣨룩0 ʾ
+    double dropout_duration = 0.0;      // ÿε߳ʱ䣨룩
+};
+
+struct SensorMeasurement {
+    double time;
+    int sensor;
+    Point2D observed;
+    Point2D truth;
+};
+
+template <typename Model>
+class EventDrivenSimulator {
+private:
+    enum class EventType { ProcessUpdate, SensorSample, DropoutBegin, DropoutEnd };
+
+    struct Event {
+        double time;
+        std::uint64_t seq;   // ͬһʱ̰˳֤ȷ
+        EventType type;
+        int sensor;
+
+        bool operator>(const Event& other) const
+        {
+            return time != other.time ? time > other.time : seq > other.seq;
+        }
+    };
+
+    struct SensorSlot {
+        SensorConfig config;
+        bool online = true;
+    };
+
+    MotionState state;
+    double now = 0.0;
+    double process_period;
+    std::default_random_engine generator;
+    std::normal_distribution<double> process_noise;
+    std::vector<SensorSlot> sensors;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    std::uint64_t next_seq = 0;
+
+    void schedule(double time, EventType type, int sensor = -1)
+    {
+        queue.push(Event{time, next_seq++, type, sensor});
+    }
+
+    void advanceTo(double t)
+    {
+        if (t > now) {
+            Model::step(state, t - now);
+            now = t;
+        }
+    }
+
+    double nextSampleTime(const SensorConfig& cfg)
+    {
+        double period = 1.0 / cfg.rate_hz;
+        if (cfg.jitter_stddev > 0.0) {
+            std::normal_distribution<double> jitter(0.0, cfg.jitter_stddev);
+            period = std::max(period * 0.1, period + jitter(generator));
+        }
+        return now + period;
+    }
+
+    void scheduleDropout(int sensor)
+    {
+        const SensorConfig& cfg = sensors[sensor].config;
+        if (cfg.mean_time_to_dropout > 0.0) {
+            std::exponential_distribution<double> uptime(1.0 / cfg.mean_time_to_dropout);
+            schedule(now + uptime(generator), EventType::DropoutBegin, sensor);
+        }
+    }
+
+public:
+    // process_period Ϊעڣÿٶȵ N(0, process_noise_stddev^2)
+    EventDrivenSimulator(MotionState initial, double process_period, double process_noise_stddev,
+                         unsigned seed = std::random_device{}())
+        : state(initial), process_period(process_period), generator(seed),
+          process_noise(0.0, process_noise_stddev) {}
+
+    int addSensor(const SensorConfig& config)
+    {
+        if (config.rate_hz <= 0.0) {
+            throw std::invalid_argument("ʱΪ");
+        }
+        sensors.push_back(SensorSlot{config, true});
+        return static_cast<int>(sensors.size()) - 1;
+    }
+
+    std::vector<SensorMeasurement> run(double total_time)
+    {
+        std::vector<SensorMeasurement> measurements;
+        if (process_period > 0.0 && process_noise.stddev() > 0.0) {
+            schedule(process_period, EventType::ProcessUpdate);
+        }
+        for (int i = 0; i < static_cast<int>(sensors.size()); ++i) {
+            schedule(nextSampleTime(sensors[i].config), EventType::SensorSample, i);
+            scheduleDropout(i);
+        }
+
+        while (!queue.empty() && queue.top().time <= total_time) {
+            const Event ev = queue.top();
+            queue.pop();
+            advanceTo(ev.time);
+
+            switch (ev.type) {
+            case EventType::ProcessUpdate:
+                state.vel.x += process_noise(generator);
+                state.vel.y += process_noise(generator);
+                schedule(now + process_period, EventType::ProcessUpdate);
+                break;
+            case EventType::SensorSample: {
+                SensorSlot& slot = sensors[ev.sensor];
+                if (slot.online) {
+                    std::normal_distribution<double> noise(0.0, slot.config.noise_stddev);
+                    Point2D z{state.pos.x + noise(generator), state.pos.y + noise(generator)};
+                    measurements.push_back(SensorMeasurement{now, ev.sensor, z, state.pos});
+                }
+                schedule(nextSampleTime(slot.config), EventType::SensorSample, ev.sensor);
+                break;
+            }
+            case EventType::DropoutBegin:
+                sensors[ev.sensor].online = false;
+                schedule(now + sensors[ev.sensor].config.dropout_duration, EventType::DropoutEnd, ev.sensor);
+                break;
+            case EventType::DropoutEnd:
+                sensors[ev.sensor].online = true;
+                scheduleDropout(ev.sensor);
+                break;
+            }
+        }
+        advanceTo(total_time);
+        return measurements;
+    }
+
+    const MotionState& currentState() const { return state; }
+    double currentTime() const { return now; }
+};
+
+// ʱ棺ѡĶʷΪ 0 ʱȫʷ
+class TrajectoryHistory {
+private:
+    std::size_t capacity;
+    std::vector<Point2D> data;
+    std::size_t head = 0;          // ʱԪصλ
+    std::uint64_t total = 0;       // ۼд
+
+public:
+    explicit TrajectoryHistory(std::size_t capacity = 0) : capacity(capacity)
+    {
+        if (capacity > 0) data.reserve(capacity);
+    }
+
+    void push(Point2D p)
+    {
+        ++total;
+        if (capacity == 0 || data.size() < capacity) {
+            data.push_back(p);
+            return;
+        }
+        data[head] = p;
+        head = (head + 1) % capacity;
+    }
+
+    // Ӽָʱԭۼд
+    void restoreTotal(std::uint64_t pushed) { total = pushed; }
+
+    std::size_t size() const { return data.size(); }
+    std::size_t maxSize() const { return capacity; }
+    std::uint64_t totalPushed() const { return total; }
+
+    // ʱ˳ʣ0 ΪԪ
+    const Point2D& operator[](std::size_t i) const
+    {
+        return data[(head + i) % data.size()];
+    }
+
+    std::vector<Point2D> toVector() const
+    {
+        std::vector<Point2D> out(data.size());
+        for (std::size_t i = 0; i < data.size(); ++i) out[i] = (*this)[i];
+        return out;
+    }
+};
+
+// 3 Ŀ汾λáٶȺ״̬ڶдλһµػָ
+// ƽ simulateWithProcessNoise ͬ
+class ProcessNoiseSimulation {
+private:
+    double dt;
+    std::uint64_t step = 0;
+    Point2D position;
+    Point2D velocity;
+    std::default_random_engine generator;
+    std::normal_distribution<double> process_noise;
+    TrajectoryHistory trail;
+
+public:
+    ProcessNoiseSimulation(double dt, Point2D initial_pos, Point2D initial_velocity,
+                           double process_noise_stddev, unsigned seed = std::random_device{}(),
+                           std::size_t history_capacity = 0)
+        : dt(dt), position(initial_pos), velocity(initial_velocity), generator(seed),
+          process_noise(0.0, process_noise_stddev), trail(history_capacity)
+    {
+        trail.push(position);
+    }
+
+    void advance(std::uint64_t steps)
+    {
+        for (std::uint64_t i = 0; i < steps; ++i) {
+            velocity.x += process_noise(generator);
+            velocity.y += process_noise(generator);
+            position.x += velocity.x * dt;
+            position.y += velocity.y * dt;
+            trail.push(position);
+        }
+        step += steps;
+    }
+
+    // ʮƸʽ棬ͷֲĵڶ̬ñ׼ʽ
+    void saveCheckpoint(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("޷д: " + path);
+        }
+        out << "PNSIM1\n" << std::hexfloat
+            << dt << ' ' << step << '\n'
+            << position.x << ' ' << position.y << ' ' << velocity.x << ' ' << velocity.y << '\n'
+            << generator << '\n' << process_noise << '\n'
+            << trail.maxSize() << ' ' << trail.totalPushed() << ' ' << trail.size() << '\n';
+        for (std::size_t i = 0; i < trail.size(); ++i) out << trail[i].x << ' ' << trail[i].y << '\n';
+        if (!out) {
+            throw std::runtime_error("дʧ: " + path);
+        }
+    }
+
+    static ProcessNoiseSimulation loadCheckpoint(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string magic;
+        if (!in || !(in >> magic) || magic != "PNSIM1") {
+            throw std::runtime_error("Чļļ: " + path);
+        }
+        // std::hexfloat Ķڲֱ׼ϲã strtod 
+        auto readDouble = [&]() {
+            std::string token;
+            in >> token;
+            char* end = nullptr;
+            const double value = std::strtod(token.c_str(), &end);
+            if (token.empty() || end != token.c_str() + token.size()) {
+                throw std::runtime_error("ļ: " + path);
+            }
+            return value;
+        };
+
+        ProcessNoiseSimulation sim(1.0, {0.0, 0.0}, {0.0, 0.0}, 1.0);
+        sim.dt = readDouble();
+        in >> sim.step;
+        sim.position.x = readDouble();
+        sim.position.y = readDouble();
+        sim.velocity.x = readDouble();
+        sim.velocity.y = readDouble();
+        // ׼ operator>> ǰհףҪֶ
+        in >> std::ws >> sim.generator >> std::ws >> sim.process_noise;
+
+        std::size_t capacity = 0, count = 0;
+        std::uint64_t pushed = 0;
+        in >> capacity >> pushed >> count;
+        sim.trail = TrajectoryHistory(capacity);
+        for (std::size_t i = 0; i < count; ++i) {
+            const double x = readDouble();
+            const double y = readDouble();
+            sim.trail.push({x, y});
+        }
+        if (!in) {
+            throw std::runtime_error("ļ: " + path);
+        }
+        sim.trail.restoreTotal(pushed);
+        return sim;
+    }
+
+    double time() const { return static_cast<double>(step) * dt; }
+    std::uint64_t steps() const { return step; }
+    Point2D currentPosition() const { return position; }
+    Point2D currentVelocity() const { return velocity; }
+    const TrajectoryHistory& history() const { return trail; }
+};
+
+// ԴͳһΪر׼̬Ŀɵö
+// 滻 addMeasurementNoise / simulateWithProcessNoise е std::normal_distribution
+
+// ׼ֲ̬ķAcklam ƽ + һ Halley Լ 1e-15
+double inverseNormalCdf(double p)
+{
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    if (p <= 0.0) return -INFINITY;
+    if (p >= 1.0) return INFINITY;
+
+    double x;
+    if (p < 0.02425) {
+        const double q = std::sqrt(-2.0 * std::log(p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else if (p > 1.0 - 0.02425) {
+        const double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else {
+        const double q = p - 0.5;
+        const double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+    const double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+    const double u = e * std::sqrt(2.0 * M_PI) * std::exp(0.5 * x * x);
+    return x - u / (1.0 + 0.5 * x * u);
+}
+
+// ͨαԴԭȼ
+class PseudoRandomNormal {
+private:
+    std::default_random_engine generator;
+    std::normal_distribution<double> dist{0.0, 1.0};
+
+public:
+    explicit PseudoRandomNormal(unsigned seed = std::random_device{}()) : generator(seed) {}
+    double operator()() { return dist(generator); }
+};
+
+// żͬһӵԴһȡ zһȡ -zɶкȡƽ
+// ĵյλá½
+class AntitheticNormal {
+private:
+    std::default_random_engine generator;
+    std::normal_distribution<double> dist{0.0, 1.0};
+    double sign;
+
+public:
+    AntitheticNormal(unsigned seed, bool negate) : generator(seed), sign(negate ? -1.0 : 1.0) {}
+    double operator()() { return sign * dist(generator); }
+};
+
+// Sobol ͲУGray ƣάޣǰ 16 άʹ Joe-Kuo 
+// ֮󰴴ö GF(2) ϵıԭʽʼȡ̶ɵSobol ԭʼ
+// ÿάһλƣdigital shift֤ƫöظ
+class SobolSequence {
+private:
+    static constexpr int bits = 32;
+    unsigned dims;
+    std::uint32_t index = 0;
+    std::vector<std::uint32_t> direction;   // [dim][bit]
+    std::vector<std::uint32_t> state;
+    std::vector<std::uint32_t> shift;
+
+    // ԭʽ x^s + a_1 x^{s-1} + ... + a_{s-1} x + 1a ĸλΪ a_1..a_{s-1}
+    struct Poly {
+        unsigned s;
+        std::uint32_t a;
+    };
+
+    // GF(2)[x] / p еĳ˷p Ϊ s ζʽλ
+    static std::uint64_t mulMod(std::uint64_t a, std::uint64_t b, std::uint64_t p, unsigned s)
+    {
+        std::uint64_t result = 0;
+        for (; b; b >>= 1) {
+            if (b & 1u) result ^= a;
+            a <<= 1;
+            if ((a >> s) & 1u) a ^= p;
+        }
+        return result;
+    }
+
+    static std::uint64_t powX(std::uint64_t e, std::uint64_t p, unsigned s)
+    {
+        std::uint64_t base = 2, result = 1;
+        if ((base >> s) & 1u) base ^= p;
+        for (; e; e >>= 1) {
+            if (e & 1u) result = mulMod(result, base, p, s);
+            base = mulMod(base, base, p, s);
+        }
+        return result;
+    }
+
+    //  (, a) ˳ǰ count ԭʽx ĽǡΪ 2^s - 1 Ϊԭ
+    static std::vector<Poly> primitivePolynomials(std::size_t count)
+    {
+        std::vector<Poly> polys;
+        for (unsigned s = 1; polys.size() < count; ++s) {
+            if (s >= static_cast<unsigned>(bits)) throw std::invalid_argument("Sobol άַ֧Χ");
+            const std::uint64_t order = (std::uint64_t(1) << s) - 1;
+            std::vector<std::uint64_t> factors;
+            std::uint64_t rest = order;
+            for (std::uint64_t f = 3; f * f <= rest; f += 2) {
+                if (rest % f == 0) factors.push_back(f);
+                while (rest % f == 0) rest /= f;
+            }
+            if (rest > 1) factors.push_back(rest);
+
+            for (std::uint32_t a = 0; a < (1u << (s - 1)) && polys.size() < count; ++a) {
+                const std::uint64_t p = (std::uint64_t(1) << s) | (std::uint64_t(a) << 1) | 1u;
+                if (powX(order, p, s) != 1) continue;
+                bool primitive = true;
+                for (std::uint64_t f : factors) {
+                    if (powX(order / f, p, s) == 1) {
+                        primitive = false;
+                        break;
+                    }
+                }
+                if (primitive) polys.push_back({s, a});
+            }
+        }
+        return polys;
+    }
+
+public:
+    explicit SobolSequence(unsigned dimensions, unsigned seed = std::random_device{}())
+        : dims(dimensions), direction(std::size_t(dimensions) * bits), state(dimensions, 0), shift(dimensions, 0)
+    {
+        static const std::uint32_t joe_kuo_m[15][6] = {
+            {1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3}, {1, 3, 5, 13}, {1, 1, 5, 5, 17},
+            {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}, {1, 1, 5, 1, 1}, {1, 1, 1, 3, 11}, {1, 3, 5, 5, 31},
+            {1, 3, 3, 9, 7, 49}, {1, 1, 1, 15, 21, 21}, {1, 3, 1, 13, 27, 49},
+        };
+        if (dimensions == 0) {
+            throw std::invalid_argument("Sobol άΪ");
+        }
+        const std::vector<Poly> polys = primitivePolynomials(dims - 1);
+        //  0 άΪ van der Corput 
+        for (int k = 0; k < bits; ++k) direction[k] = 1u << (bits - 1 - k);
+        for (unsigned d = 1; d < dims; ++d) {
+            const Poly& poly = polys[d - 1];
+            std::uint32_t m[bits];
+            if (d <= 15) {
+                std::copy(joe_kuo_m[d - 1], joe_kuo_m[d - 1] + poly.s, m);
+            } else {
+                std::mt19937 init(d);
+                for (unsigned k = 0; k < poly.s; ++k) m[k] = (init() & ((2u << k) - 1)) | 1u;
+            }
+            std::uint32_t* v = &direction[std::size_t(d) * bits];
+            for (unsigned k = 0; k < poly.s; ++k) v[k] = m[k] << (bits - 1 - k);
+            for (unsigned k = poly.s; k < static_cast<unsigned>(bits); ++k) {
+                std::uint32_t x = v[k - poly.s] ^ (v[k - poly.s] >> poly.s);
+                for (unsigned j = 1; j < poly.s; ++j) {
+                    if ((poly.a >> (poly.s - 1 - j)) & 1u) x ^= v[k - j];
+                }
+                v[k] = x;
+            }
+        }
+        std::mt19937 rng(seed);
+        for (auto& sh : shift) sh = rng();
+    }
+
+    unsigned dimensions() const { return dims; }
+
+    // дһ㣨ÿάλ (0, 1) 䣩
+    void next(double* point)
+    {
+        //  n+1  =  n  v_cc Ϊ n λ
+        unsigned c = 0;
+        for (std::uint32_t i = index; i & 1u; i >>= 1) ++c;
+        ++index;
+        for (unsigned d = 0; d < dims; ++d) {
+            point[d] = (static_cast<double>(state[d] ^ shift[d]) + 0.5) / 4294967296.0;
+            state[d] ^= direction[std::size_t(d) * bits + c];
+        }
+    }
+};
+
+// ؿԴÿȡ Sobol еһ㣬 i ɸõ i ά CDF õ
+// άα롣Ͳֻǰά壬
+// Ե÷ӦӰǰ棨ĲŹ죩
+// 𲽶άͬҪû
+class QuasiRandomNormal {
+private:
+    std::vector<double> point;
+    std::size_t used = 0;
+    PseudoRandomNormal padding;
+
+public:
+    QuasiRandomNormal(SobolSequence& sequence, unsigned padding_seed)
+        : point(sequence.dimensions()), padding(padding_seed)
+    {
+        sequence.next(point.data());
+    }
+
+    double operator()()
+    {
+        return used < point.size() ? inverseNormalCdf(point[used++]) : padding();
+    }
+};
+
+// 2ɻԴ
+template <typename NormalSource>
+std::vector<Point2D> addMeasurementNoiseWith(
+    const std::vector<Point2D>& true_positions, double noise_stddev, NormalSource& normal)
+{
+    std::vector<Point2D> noisy_positions;
+    noisy_positions.reserve(true_positions.size());
+    for (const auto& pos : true_positions) {
+        Point2D noisy_pos;
+        noisy_pos.x = pos.x + noise_stddev * normal();
+        noisy_pos.y = pos.y + noise_stddev * normal();
+        noisy_positions.push_back(noisy_pos);
+    }
+    return noisy_positions;
+}
+
+// 3ɻԴٶ v_i = v_0 + q W_iW òŹ졪
+// ȡյ W_nȡе㣬ǰ̬·Ĵ߶״
+// ؿǰάǡҪķϡxy Žڵ㽻ȡ
+// ԶֲͬԴۼֲͬ·ͬ
+template <typename NormalSource>
+std::vector<Point2D> simulateWithProcessNoiseWith(
+    double total_time, double dt, Point2D initial_pos,
+    Point2D initial_velocity, double process_noise_stddev, NormalSource& normal)
+{
+    int steps = static_cast<int>(total_time / dt);
+    std::vector<Point2D> positions;
+    positions.reserve(steps + 1);
+    positions.push_back(initial_pos);
+    if (steps <= 0) return positions;
+
+    std::vector<Point2D> w(steps + 1, Point2D{0.0, 0.0});
+    const double root_n = std::sqrt(static_cast<double>(steps));
+    w[steps].x = root_n * normal();
+    w[steps].y = root_n * normal();
+
+    // 㣨ȣз (l, r)е m
+    struct Span {
+        int l, r;
+    };
+    std::vector<Span> spans{{0, steps}};
+    for (std::size_t i = 0; i < spans.size(); ++i) {
+        const Span s = spans[i];
+        if (s.r - s.l < 2) continue;
+        const int m = s.l + (s.r - s.l) / 2;
+        const double a = static_cast<double>(m - s.l), b = static_cast<double>(s.r - m);
+        const double sd = std::sqrt(a * b / (a + b));
+        w[m].x = (b * w[s.l].x + a * w[s.r].x) / (a + b) + sd * normal();
+        w[m].y = (b * w[s.l].y + a * w[s.r].y) / (a + b) + sd * normal();
+        spans.push_back({s.l, m});
+        spans.push_back({m, s.r});
+    }
+
+    for (int i = 1; i <= steps; ++i) {
+        Point2D p;
+        p.x = positions.back().x + (initial_velocity.x + process_noise_stddev * w[i].x) * dt;
+        p.y = positions.back().y + (initial_velocity.y + process_noise_stddev * w[i].y) * dt;
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+// йߣ [0, n) ̶Сп飬ɶ߳ȡִ body(begin, end, chunk)
+// 黮߳޹أ˰鲥ֵɸ
+template <typename Body>
+void parallelChunks(std::size_t n, std::size_t chunk_size, Body body, unsigned num_threads = 0)
+{
+    if (n == 0) return;
+    const std::size_t chunks = (n + chunk_size - 1) / chunk_size;
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = static_cast<unsigned>(std::min<std::size_t>(num_threads, chunks));
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t c = next++; c < chunks; c = next++) {
+            std::size_t begin = c * chunk_size;
+            body(begin, std::min(n, begin + chunk_size), c);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < num_threads; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& th : threads) th.join();
+}
+
+// ȡ̳߳أÿ߳ԼУӶβȡԼ
+// п˾ʹ̵߳ĶȡʱҲֲܾ
+class WorkStealingPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    bool popLocal(std::size_t self, std::function<void()>& task)
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(std::size_t self, std::function<void()>& task)
+    {
+        for (std::size_t k = 1; k < queues.size(); ++k) {
+            Queue& q = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(unsigned num_threads = 0)
+    {
+        if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < num_threads; ++i) queues.push_back(std::make_unique<Queue>());
+    }
+
+    // ִȫ񲢵ȴɣжжռ˳
+    void run(std::vector<std::function<void()>> tasks)
+    {
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            queues[i % queues.size()]->tasks.push_back(std::move(tasks[i]));
+        }
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto worker = [&](std::size_t self) {
+            std::function<void()> task;
+            while (popLocal(self, task) || steal(self, task)) {
+                try {
+                    task();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t t = 1; t < queues.size(); ++t) threads.emplace_back(worker, t);
+        worker(0);
+        for (auto& th : threads) th.join();
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+// 3а棩켣ǰ׺ͻ
+// ٶ v_i = v0 + S_iS_i Ϊǰ׺ͣλ p_i = p0 + dt * (i * v0 + sum_{j<=i} S_j)
+// ɣֲɨ裬ƫ˳ϲлλ
+std::vector<Point2D> simulateWithProcessNoiseScan(
+    double total_time, double dt, Point2D initial_pos,
+    Point2D initial_velocity, double process_noise_stddev,
+    unsigned seed = std::random_device{}(), unsigned num_threads = 0)
+{
+    constexpr std::size_t chunk_size = 4096;
+    const std::size_t steps = static_cast<std::size_t>(total_time / dt);
+
+    // ṹ鲼֣x/y ֿţڱ
+    std::vector<double> qx(steps), qy(steps);   //  S_j ľֲǰ׺
+
+    const std::size_t chunks = (steps + chunk_size - 1) / chunk_size;
+    struct ChunkSum { double nx, ny, sx, sy; };
+    std::vector<ChunkSum> sums(chunks);
+
+    // һ飺ɨ
+    parallelChunks(steps, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+        std::seed_seq seq{seed, static_cast<unsigned>(c)};
+        std::default_random_engine generator(seq);
+        std::normal_distribution<double> process_noise(0.0, process_noise_stddev);
+
+        double nx = 0.0, ny = 0.0, ax = 0.0, ay = 0.0;
+        for (std::size_t i = begin; i < end; ++i) {
+            nx += process_noise(generator);
+            ny += process_noise(generator);
+            ax += nx;
+            ay += ny;
+            qx[i] = ax;
+            qy[i] = ay;
+        }
+        sums[c] = {nx, ny, ax, ay};
+    }, num_threads);
+
+    // ƫƣO_c Ϊ֮ǰ֮ͣP_c Ϊ֮ǰ S_j ֮
+    std::vector<ChunkSum> offsets(chunks);
+    ChunkSum running{0.0, 0.0, 0.0, 0.0};
+    for (std::size_t c = 0; c < chunks; ++c) {
+        offsets[c] = running;
+        const double len = static_cast<double>(std::min(chunk_size, steps - c * chunk_size));
+        running.sx += sums[c].sx + len * running.nx;
+        running.sy += sums[c].sy + len * running.ny;
+        running.nx += sums[c].nx;
+        running.ny += sums[c].ny;
+    }
+
+    // ڶ飺ϿƫƲΪλãѭ
+    std::vector<Point2D> positions(steps + 1);
+    positions[0] = initial_pos;
+    parallelChunks(steps, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+        const ChunkSum o = offsets[c];
+        for (std::size_t i = begin; i < end; ++i) {
+            const double k = static_cast<double>(i - begin + 1);
+            const double n = static_cast<double>(i + 1);
+            positions[i + 1].x = initial_pos.x + dt * (n * initial_velocity.x + o.sx + k * o.nx + qx[i]);
+            positions[i + 1].y = initial_pos.y + dt * (n * initial_velocity.y + o.sy + k * o.ny + qy[i]);
+        }
+    }, num_threads);
+
+    return positions;
+}
+
+// ģʽģؿʱ float SoASIMD ȷڴ롣
+// Ϊⳤ켣ۻλúٶȲɡdouble ê + float 
+// ÿ anchor_interval ê㲢㣬float ֻʾһСڵı仯
+class FloatTrajectoryBatch {
+private:
+    std::size_t count;
+    float dt;
+    unsigned anchor_interval;
+    unsigned since_anchor = 0;
+    std::vector<double> anchor_x, anchor_y, anchor_vx, anchor_vy;
+    std::vector<float> anchor_vx_f, anchor_vy_f;   // êٶȵ float êʱˢ
+    std::vector<float> dx, dy, dvx, dvy;   // ê
+    std::vector<float> noise_x, noise_y;
+    std::default_random_engine generator;
+    std::normal_distribution<float> process_noise;
+
+    void reanchor()
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            anchor_x[i] += dx[i];
+            anchor_y[i] += dy[i];
+            anchor_vx[i] += dvx[i];
+            anchor_vy[i] += dvy[i];
+            anchor_vx_f[i] = static_cast<float>(anchor_vx[i]);
+            anchor_vy_f[i] = static_cast<float>(anchor_vy[i]);
+        }
+        std::fill(dx.begin(), dx.end(), 0.0f);
+        std::fill(dy.begin(), dy.end(), 0.0f);
+        std::fill(dvx.begin(), dvx.end(), 0.0f);
+        std::fill(dvy.begin(), dvy.end(), 0.0f);
+        since_anchor = 0;
+    }
+
+public:
+    FloatTrajectoryBatch(std::size_t n, double dt, Point2D initial_pos, Point2D initial_velocity,
+                         double process_noise_stddev, unsigned seed = std::random_device{}(),
+                         unsigned anchor_interval = 64)
+        : count(n), dt(static_cast<float>(dt)), anchor_interval(std::max(1u, anchor_interval)),
+          anchor_x(n, initial_pos.x), anchor_y(n, initial_pos.y),
+          anchor_vx(n, initial_velocity.x), anchor_vy(n, initial_velocity.y),
+          anchor_vx_f(n, static_cast<float>(initial_velocity.x)), anchor_vy_f(n, static_cast<float>(initial_velocity.y)),
+          dx(n, 0.0f), dy(n, 0.0f), dvx(n, 0.0f), dvy(n, 0.0f), noise_x(n), noise_y(n),
+          generator(seed), process_noise(0.0f, static_cast<float>(process_noise_stddev)) {}
+
+    // ƽһ float ѭ
+    void step()
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            noise_x[i] = process_noise(generator);
+            noise_y[i] = process_noise(generator);
+        }
+        // êٶһêڲ䣬ѭֻ float  double 
+        const float h = dt;
+        for (std::size_t i = 0; i < count; ++i) {
+            dvx[i] += noise_x[i];
+            dvy[i] += noise_y[i];
+            dx[i] += (anchor_vx_f[i] + dvx[i]) * h;
+            dy[i] += (anchor_vy_f[i] + dvy[i]) * h;
+        }
+        if (++since_anchor >= anchor_interval) reanchor();
+    }
+
+    void advance(std::uint64_t steps)
+    {
+        for (std::uint64_t k = 0; k < steps; ++k) step();
+    }
+
+    std::size_t size() const { return count; }
+    Point2D position(std::size_t i) const { return {anchor_x[i] + dx[i], anchor_y[i] + dy[i]}; }
+    Point2D velocity(std::size_t i) const { return {anchor_vx[i] + dvx[i], anchor_vy[i] + dvy[i]}; }
+};
+
+// 3Ȱ棩 simulateWithProcessNoise ͬһģͣںʹ float +  double ê
+std::vector<Point2D> simulateWithProcessNoiseFloat(
+    double total_time, double dt, Point2D initial_pos,
+    Point2D initial_velocity, double process_noise_stddev)
+{
+    int steps = static_cast<int>(total_time / dt);
+    std::vector<Point2D> positions;
+    positions.reserve(steps + 1);
+    positions.push_back(initial_pos);
+
+    FloatTrajectoryBatch batch(1, dt, initial_pos, initial_velocity, process_noise_stddev);
+    for (int i = 1; i <= steps; ++i) {
+        batch.step();
+        positions.push_back(batch.position(0));
+    }
+    return positions;
+}
+
+// ڶȫջϣѭϽΪȫչ
+template <int R, int C>
+struct Mat {
+    double m[R][C];
+
+    static constexpr Mat zero()
+    {
+        Mat r{};
+        return r;
+    }
+
+    static constexpr Mat identity()
+    {
+        static_assert(R == C, "λΪ");
+        Mat r{};
+        for (int i = 0; i < R; ++i) r.m[i][i] = 1.0;
+        return r;
+    }
+
+    constexpr double& operator()(int i, int j) { return m[i][j]; }
+    constexpr const double& operator()(int i, int j) const { return m[i][j]; }
+
+    constexpr Mat<C, R> transpose() const
+    {
+        Mat<C, R> r{};
+        for (int i = 0; i < R; ++i)
+            for (int j = 0; j < C; ++j) r.m[j][i] = m[i][j];
+        return r;
+    }
+};
+
+template <int R, int C>
+constexpr Mat<R, C> operator+(const Mat<R, C>& a, const Mat<R, C>& b)
+{
+    Mat<R, C> r{};
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j) r.m[i][j] = a.m[i][j] + b.m[i][j];
+    return r;
+}
+
+template <int R, int C>
+constexpr Mat<R, C> operator-(const Mat<R, C>& a, const Mat<R, C>& b)
+{
+    Mat<R, C> r{};
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j) r.m[i][j] = a.m[i][j] - b.m[i][j];
+    return r;
+}
+
+template <int R, int K, int C>
+constexpr Mat<R, C> operator*(const Mat<R, K>& a, const Mat<K, C>& b)
+{
+    Mat<R, C> r{};
+    for (int i = 0; i < R; ++i)
+        for (int k = 0; k < K; ++k)
+            for (int j = 0; j < C; ++j) r.m[i][j] += a.m[i][k] * b.m[k][j];
+    return r;
+}
+
+template <int R, int C>
+constexpr Mat<R, C> operator*(double s, const Mat<R, C>& a)
+{
+    Mat<R, C> r{};
+    for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j) r.m[i][j] = s * a.m[i][j];
+    return r;
+}
+
+// 2x2 棨ʽ⣩ϢЭֻ 2 ά
+inline Mat<2, 2> inverse(const Mat<2, 2>& a)
+{
+    const double det = a.m[0][0] * a.m[1][1] - a.m[0][1] * a.m[1][0];
+    if (det == 0.0) {
+        throw std::runtime_error("죬޷");
+    }
+    const double inv = 1.0 / det;
+    return Mat<2, 2>{{{a.m[1][1] * inv, -a.m[0][1] * inv},
+                      {-a.m[1][0] * inv, a.m[0][0] * inv}}};
+}
+
+// һ㷽棨Gauss-JordanԪƽе 4x4 ԤЭ
+template <int N>
+Mat<N, N> inverse(Mat<N, N> a)
+{
+    Mat<N, N> inv = Mat<N, N>::identity();
+    for (int col = 0; col < N; ++col) {
+        int pivot = col;
+        for (int r = col + 1; r < N; ++r) {
+            if (std::fabs(a(r, col)) > std::fabs(a(pivot, col))) pivot = r;
+        }
+        if (a(pivot, col) == 0.0) {
+            throw std::runtime_error("죬޷");
+        }
+        if (pivot != col) {
+            for (int j = 0; j < N; ++j) {
+                std::swap(a(col, j), a(pivot, j));
+                std::swap(inv(col, j), inv(pivot, j));
+            }
+        }
+        const double scale = 1.0 / a(col, col);
+        for (int j = 0; j < N; ++j) {
+            a(col, j) *= scale;
+            inv(col, j) *= scale;
+        }
+        for (int r = 0; r < N; ++r) {
+            if (r == col) continue;
+            const double f = a(r, col);
+            for (int j = 0; j < N; ++j) {
+                a(r, j) -= f * a(col, j);
+                inv(r, j) -= f * inv(col, j);
+            }
+        }
+    }
+    return inv;
+}
+
+// Cholesky ֽ A = L L^TA Գ
+template <int N>
+Mat<N, N> cholesky(const Mat<N, N>& a)
+{
+    Mat<N, N> L = Mat<N, N>::zero();
+    for (int j = 0; j < N; ++j) {
+        double d = a(j, j);
+        for (int k = 0; k < j; ++k) d -= L(j, k) * L(j, k);
+        if (d <= 0.0) {
+            throw std::invalid_argument("Э");
+        }
+        L(j, j) = std::sqrt(d);
+        for (int i = j + 1; i < N; ++i) {
+            double v = a(i, j);
+            for (int k = 0; k < j; ++k) v -= L(i, k) * L(j, k);
+            L(i, j) = v / L(j, j);
+        }
+    }
+    return L;
+}
+
+using Vec2 = Mat<2, 1>;
+using Vec4 = Mat<4, 1>;
+using Mat2 = Mat<2, 2>;
+using Mat4 = Mat<4, 4>;
+
+// صĶά˹ʱЭһ Cholesky ֽⲢ L
+// ֮ɱ׼̬ L Ա任ÿֻ̬
+// ԭͬͬ任ѭ
+class CorrelatedNoise2D {
+private:
+    Mat2 L;
+    std::default_random_engine generator;
+    std::normal_distribution<double> std_normal{0.0, 1.0};
+    std::vector<double> z0, z1;
+
+public:
+    explicit CorrelatedNoise2D(const Mat2& covariance, unsigned seed = std::random_device{}())
+        : L(cholesky(covariance)), generator(seed) {}
+
+    // ɸ׼ϵЭ
+    static Mat2 covariance(double stddev_x, double stddev_y, double correlation)
+    {
+        const double c = correlation * stddev_x * stddev_y;
+        return Mat2{{{stddev_x * stddev_x, c}, {c, stddev_y * stddev_y}}};
+    }
+
+    void fill(double* dx, double* dy, std::size_t n)
+    {
+        z0.resize(n);
+        z1.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            z0[i] = std_normal(generator);
+            z1[i] = std_normal(generator);
+        }
+        const double l00 = L(0, 0), l10 = L(1, 0), l11 = L(1, 1);
+        const double* a = z0.data();
+        const double* b = z1.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            dx[i] = l00 * a[i];
+            dy[i] = l10 * a[i] + l11 * b[i];
+        }
+    }
+
+    Point2D sample()
+    {
+        const double a = std_normal(generator);
+        const double b = std_normal(generator);
+        return {L(0, 0) * a, L(1, 0) * a + L(1, 1) * b};
+    }
+
+    const Mat2& factor() const { return L; }
+};
+
+// 2棩ԴֵӲ
+std::vector<Point2D> addCorrelatedMeasurementNoise(
+    const std::vector<Point2D>& true_positions, CorrelatedNoise2D& noise)
+{
+    const std::size_t n = true_positions.size();
+    std::vector<double> dx(n), dy(n);
+    noise.fill(dx.data(), dy.data(), n);
+
+    std::vector<Point2D> noisy_positions(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        noisy_positions[i].x = true_positions[i].x + dx[i];
+        noisy_positions[i].y = true_positions[i].y + dy[i];
+    }
+    return noisy_positions;
+}
+
+// ģ͵״̬תƾ״̬Ϊ [x, y, vx, vy]
+inline Mat4 transitionCV(double dt)
+{
+    Mat4 F = Mat4::identity();
+    F(0, 2) = dt;
+    F(1, 3) = dt;
+    return F;
+}
+
+//  simulateWithProcessNoise һµĹÿٶȵ N(0, q^2)λٰٶȻ
+//  Q ÿΪ q^2 * [dt^2, dt; dt, 1]
+inline Mat4 processNoiseCV(double dt, double process_noise_stddev)
+{
+    const double q = process_noise_stddev * process_noise_stddev;
+    Mat4 Q = Mat4::zero();
+    for (int axis = 0; axis < 2; ++axis) {
+        Q(axis, axis) = q * dt * dt;
+        Q(axis, axis + 2) = q * dt;
+        Q(axis + 2, axis) = q * dt;
+        Q(axis + 2, axis + 2) = q;
+    }
+    return Q;
+}
+
+// ״̬Ը˹ģ x_{k+1} = F x_k + w_k  n Ϊ
+//   x_n = F^n x_0P_n = F^n P_0 (F^n)^T + Q_nQ_n = sum_{j<n} F^j Q (F^j)^T
+// ñͬʱ (F^n, Q_n) (A, QA)(B, QB) ӵ (B A, B QA B^T + QB)
+// Ԥ k ֻ O(log k) ζ˷
+template <int N>
+struct StepOperator {
+    Mat<N, N> F;
+    Mat<N, N> Q;
+};
+
+// ִ first ִ second
+template <int N>
+StepOperator<N> compose(const StepOperator<N>& first, const StepOperator<N>& second)
+{
+    return StepOperator<N>{second.F * first.F, second.F * first.Q * second.F.transpose() + second.Q};
+}
+
+template <int N>
+StepOperator<N> fastForwardOperator(const Mat<N, N>& F, const Mat<N, N>& Q, std::uint64_t steps)
+{
+    StepOperator<N> result{Mat<N, N>::identity(), Mat<N, N>::zero()};
+    StepOperator<N> power{F, Q};
+    while (steps > 0) {
+        if (steps & 1u) result = compose(result, power);
+        power = compose(power, power);
+        steps >>= 1;
+    }
+    return result;
+}
+
+template <int N>
+void fastForward(Mat<N, 1>& x, Mat<N, N>& P, const Mat<N, N>& F, const Mat<N, N>& Q, std::uint64_t steps)
+{
+    const StepOperator<N> op = fastForwardOperator(F, Q, steps);
+    x = op.F * x;
+    P = op.F * P * op.F.transpose() + op.Q;
+}
+
+// ģбʽ⣺F^n  dt  n*dtQ Ϊ q^2 [dt^2, dt; dt, 1] ʱ
+//  j  F^{n-1-j} λõϵΪ (n-j)*dt͵
+//   Q_n = q^2 [dt^2 S2, dt S1; dt S1, n]S1 = n(n+1)/2S2 = n(n+1)(2n+1)/6
+inline StepOperator<4> fastForwardCV(double dt, double process_noise_stddev, std::uint64_t steps)
+{
+    const double n = static_cast<double>(steps);
+    const double q = process_noise_stddev * process_noise_stddev;
+    const double s1 = n * (n + 1.0) / 2.0;
+    const double s2 = n * (n + 1.0) * (2.0 * n + 1.0) / 6.0;
+    StepOperator<4> op{transitionCV(n * dt), Mat4::zero()};
+    for (int axis = 0; axis < 2; ++axis) {
+        op.Q(axis, axis) = q * dt * dt * s2;
+        op.Q(axis, axis + 2) = q * dt * s1;
+        op.Q(axis + 2, axis) = q * dt * s1;
+        op.Q(axis + 2, axis + 2) = q * n;
+    }
+    return op;
+}
+
+// ֵ k λãģ
+inline Point2D constantVelocityAt(Point2D initial_pos, Point2D velocity, double dt, std::uint64_t step)
+{
+    const double t = static_cast<double>(step) * dt;
+    return {initial_pos.x + velocity.x * t, initial_pos.y + velocity.y * t};
+}
+
+// 4ٿ˲ӴĹ۲λúٶ
+// ÿֻ㣬޶ѷ
+class KalmanFilterCV {
+private:
+    Vec4 x = Vec4::zero();   // ״̬ [x, y, vx, vy]
+    Mat4 P = Mat4::identity();
+    double q_stddev;         // ׼ÿٶ
+    double r_var;            // 
+    double nis = 0.0;        // һθµĹһϢƽ
+
+public:
+    KalmanFilterCV(double process_noise_stddev, double measurement_noise_stddev)
+        : q_stddev(process_noise_stddev),
+          r_var(measurement_noise_stddev * measurement_noise_stddev) {}
+
+    void init(Point2D pos, Point2D vel, double pos_var, double vel_var)
+    {
+        x = Vec4{{{pos.x}, {pos.y}, {vel.x}, {vel.y}}};
+        P = Mat4::zero();
+        P(0, 0) = P(1, 1) = pos_var;
+        P(2, 2) = P(3, 3) = vel_var;
+    }
+
+    void predict(double dt)
+    {
+        const Mat4 F = transitionCV(dt);
+        x = F * x;
+        P = F * P * F.transpose() + processNoiseCV(dt, q_stddev);
+    }
+
+    // ۲ H = [I 0]ֱȡ P ķֿ飬ʡȥ H ĳ˷
+    void update(Point2D z)
+    {
+        const Vec2 y{{{z.x - x(0, 0)}, {z.y - x(1, 0)}}};
+        const Mat2 S{{{P(0, 0) + r_var, P(0, 1)}, {P(1, 0), P(1, 1) + r_var}}};
+        const Mat2 S_inv = inverse(S);
+        nis = (y.transpose() * S_inv * y)(0, 0);
+
+        Mat<4, 2> PHt{};
+        for (int i = 0; i < 4; ++i) {
+            PHt(i, 0) = P(i, 0);
+            PHt(i, 1) = P(i, 1);
+        }
+        const Mat<4, 2> K = PHt * S_inv;
+        x = x + K * y;
+
+        // P = (I - K H) PKH ֻǰз
+        Mat4 KHP{};
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j) KHP(i, j) = K(i, 0) * P(0, j) + K(i, 1) * P(1, j);
+        P = P - KHP;
+    }
+
+    Point2D position() const { return {x(0, 0), x(1, 0)}; }
+    Point2D velocity() const { return {x(2, 0), x(3, 0)}; }
+    // ֱ״̬۲ⲿʹ
+    void reset(const Vec4& state, const Mat4& covariance)
+    {
+        x = state;
+        P = covariance;
+    }
+
+    const Vec4& state() const { return x; }
+    const Mat4& covariance() const { return P; }
+    double normalizedInnovationSquared() const { return nis; }
+};
+
+// ۲˲ظʱ̵λù
+std::vector<Point2D> filterTrajectory(
+    const std::vector<Point2D>& observed_positions, double dt,
+    double process_noise_stddev, double measurement_noise_stddev)
+{
+    std::vector<Point2D> estimates;
+    if (observed_positions.empty()) return estimates;
+    estimates.reserve(observed_positions.size());
+
+    KalmanFilterCV filter(process_noise_stddev, measurement_noise_stddev);
+    const double r = measurement_noise_stddev * measurement_noise_stddev;
+    filter.init(observed_positions.front(), {0.0, 0.0}, r, 100.0);
+    estimates.push_back(filter.position());
+
+    for (std::size_t i = 1; i < observed_positions.size(); ++i) {
+        filter.predict(dt);
+        filter.update(observed_positions[i]);
+        estimates.push_back(filter.position());
+    }
+    return estimates;
+}
+
+// RTS ƽһǰ򿨶˲˲ٴĩβǰƽ
+// Ԥ x_pP_p һ˲ÿֻ豣˲״̬Э
+struct FilteredStep {
+    Vec4 x;
+    Mat4 P;
+};
+
+inline FilteredStep smoothStep(const FilteredStep& filtered, const FilteredStep& next_smoothed,
+                               const Mat4& F, const Mat4& Q)
+{
+    const Vec4 x_pred = F * filtered.x;
+    const Mat4 P_pred = F * filtered.P * F.transpose() + Q;
+    const Mat4 C = filtered.P * F.transpose() * inverse(P_pred);
+    return FilteredStep{filtered.x + C * (next_smoothed.x - x_pred),
+                        filtered.P + C * (next_smoothed.P - P_pred) * C.transpose()};
+}
+
+std::vector<Point2D> smoothTrajectory(
+    const std::vector<Point2D>& observed_positions, double dt,
+    double process_noise_stddev, double measurement_noise_stddev)
+{
+    const std::size_t n = observed_positions.size();
+    std::vector<Point2D> smoothed(n);
+    if (n == 0) return smoothed;
+
+    // ǰ˲
+    std::vector<FilteredStep> steps(n);
+    KalmanFilterCV filter(process_noise_stddev, measurement_noise_stddev);
+    filter.init(observed_positions.front(), {0.0, 0.0},
+                measurement_noise_stddev * measurement_noise_stddev, 100.0);
+    steps[0] = {filter.state(), filter.covariance()};
+    for (std::size_t i = 1; i < n; ++i) {
+        filter.predict(dt);
+        filter.update(observed_positions[i]);
+        steps[i] = {filter.state(), filter.covariance()};
+    }
+
+    // ƽ
+    const Mat4 F = transitionCV(dt);
+    const Mat4 Q = processNoiseCV(dt, process_noise_stddev);
+    FilteredStep next = steps[n - 1];
+    smoothed[n - 1] = {next.x(0, 0), next.x(1, 0)};
+    for (std::size_t i = n - 1; i-- > 0;) {
+        next = smoothStep(steps[i], next, F, Q);
+        smoothed[i] = {next.x(0, 0), next.x(1, 0)};
+    }
+    return smoothed;
+}
+
+// 켣֮以أ켣
+std::vector<std::vector<Point2D>> smoothTrajectories(
+    const std::vector<std::vector<Point2D>>& observed, double dt,
+    double process_noise_stddev, double measurement_noise_stddev, unsigned num_threads = 0)
+{
+    std::vector<std::vector<Point2D>> smoothed(observed.size());
+    parallelChunks(observed.size(), 1, [&](std::size_t begin, std::size_t, std::size_t) {
+        smoothed[begin] = smoothTrajectory(observed[begin], dt, process_noise_stddev, measurement_noise_stddev);
+    }, num_threads);
+    return smoothed;
+}
+
+// ʽͳƣWelford ߾ֵ/O(1) ڴ棬ɿ̺߳ϲChan ϲʽ
+class RunningStats {
+private:
+    std::uint64_t n = 0;
+    double mu = 0.0;
+    double m2 = 0.0;
+    double lo = INFINITY;
+    double hi = -INFINITY;
+
+public:
+    void add(double value)
+    {
+        ++n;
+        const double delta = value - mu;
+        mu += delta / static_cast<double>(n);
+        m2 += delta * (value - mu);
+        lo = std::min(lo, value);
+        hi = std::max(hi, value);
+    }
+
+    void merge(const RunningStats& other)
+    {
+        if (other.n == 0) return;
+        if (n == 0) {
+            *this = other;
+            return;
+        }
+        const double na = static_cast<double>(n);
+        const double nb = static_cast<double>(other.n);
+        const double delta = other.mu - mu;
+        const double total = na + nb;
+        mu += delta * nb / total;
+        m2 += other.m2 + delta * delta * na * nb / total;
+        n += other.n;
+        lo = std::min(lo, other.lo);
+        hi = std::max(hi, other.hi);
+    }
+
+    std::uint64_t count() const { return n; }
+    double mean() const { return mu; }
+    double variance() const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+    double min() const { return lo; }
+    double max() const { return hi; }
+};
+
+// ͳƣƫ뷽RMSEԼ˲һָ NEES/NIS
+class ErrorStatistics {
+private:
+    RunningStats ex, ey;        // ֵƫ
+    RunningStats sq_norm;       // ģƽֵ RMSE
+    RunningStats nees_stats;    // һƽ
+    RunningStats nis_stats;     // һϢƽ
+
+public:
+    void addPosition(Point2D estimate, Point2D truth)
+    {
+        const double dx = estimate.x - truth.x;
+        const double dy = estimate.y - truth.y;
+        ex.add(dx);
+        ey.add(dy);
+        sq_norm.add(dx * dx + dy * dy);
+    }
+
+    // NEES = e^T P^-1 eһµ˲ֵӦӽ״̬ά
+    template <int N>
+    void addNees(const Mat<N, 1>& error, const Mat<N, N>& P)
+    {
+        nees_stats.add((error.transpose() * inverse(P) * error)(0, 0));
+    }
+
+    // NIS ֵӦӽ۲ά
+    void addNis(double nis) { nis_stats.add(nis); }
+
+    void merge(const ErrorStatistics& other)
+    {
+        ex.merge(other.ex);
+        ey.merge(other.ey);
+        sq_norm.merge(other.sq_norm);
+        nees_stats.merge(other.nees_stats);
+        nis_stats.merge(other.nis_stats);
+    }
+
+    std::uint64_t count() const { return sq_norm.count(); }
+    Point2D bias() const { return {ex.mean(), ey.mean()}; }
+    Point2D errorStddev() const { return {ex.stddev(), ey.stddev()}; }
+    double rmse() const { return std::sqrt(sq_norm.mean()); }
+    double maxError() const { return sq_norm.count() ? std::sqrt(sq_norm.max()) : 0.0; }
+    const RunningStats& nees() const { return nees_stats; }
+    const RunningStats& nis() const { return nis_stats; }
+};
+
+ErrorStatistics compareTrajectories(const std::vector<Point2D>& estimate, const std::vector<Point2D>& truth)
+{
+    ErrorStatistics stats;
+    const std::size_t n = std::min(estimate.size(), truth.size());
+    for (std::size_t i = 0; i < n; ++i) stats.addPosition(estimate[i], truth[i]);
+    return stats;
+}
+
+// ˲ͳƣƹ켣NEES ȡλ÷2 ά
+ErrorStatistics evaluateFilter(
+    const std::vector<Point2D>& true_positions, const std::vector<Point2D>& observed_positions,
+    double dt, double process_noise_stddev, double measurement_noise_stddev)
+{
+    ErrorStatistics stats;
+    const std::size_t n = std::min(true_positions.size(), observed_positions.size());
+    if (n == 0) return stats;
+
+    KalmanFilterCV filter(process_noise_stddev, measurement_noise_stddev);
+    filter.init(observed_positions.front(), {0.0, 0.0},
+                measurement_noise_stddev * measurement_noise_stddev, 100.0);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i > 0) {
+            filter.predict(dt);
+            filter.update(observed_positions[i]);
+            stats.addNis(filter.normalizedInnovationSquared());
+        }
+        const Point2D est = filter.position();
+        stats.addPosition(est, true_positions[i]);
+        const Mat4& P = filter.covariance();
+        stats.addNees(Vec2{{{est.x - true_positions[i].x}, {est.y - true_positions[i].y}}},
+                      Mat2{{{P(0, 0), P(0, 1)}, {P(1, 0), P(1, 1)}}});
+    }
+    return stats;
+}
+
+// ɨеֵֵ켣ֻɳ޹أ
+// ÿͬĳֻһΣֻ shared_ptr ʵ֮乲
+struct TruthScenario {
+    double total_time = 5.0;
+    double dt = 0.01;
+    Point2D initial_pos{0.0, 0.0};
+    Point2D velocity{2.0, 3.0};
+
+    bool operator<(const TruthScenario& o) const
+    {
+        const double a[] = {total_time, dt, initial_pos.x, initial_pos.y, velocity.x, velocity.y};
+        const double b[] = {o.total_time, o.dt, o.initial_pos.x, o.initial_pos.y, o.velocity.x, o.velocity.y};
+        return std::lexicographical_compare(a, a + 6, b, b + 6);
+    }
+};
+
+using SharedTrajectory = std::shared_ptr<const std::vector<Point2D>>;
+
+// ̰߳ȫֵ棺ͬһʱֻһ̼߳㣬̵߳ȴ
+class TruthCache {
+private:
+    struct Entry {
+        std::once_flag once;
+        SharedTrajectory trajectory;
+    };
+
+    std::mutex mutex;
+    std::map<TruthScenario, std::unique_ptr<Entry>> entries;
+
+public:
+    SharedTrajectory get(const TruthScenario& scenario)
+    {
+        Entry* entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& slot = entries[scenario];
+            if (!slot) slot = std::make_unique<Entry>();
+            entry = slot.get();
+        }
+        std::call_once(entry->once, [&]() {
+            entry->trajectory = std::make_shared<const std::vector<Point2D>>(simulateConstantVelocity(
+                scenario.total_time, scenario.dt, scenario.initial_pos, scenario.velocity));
+        });
+        return entry->trajectory;
+    }
+
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+};
+
+// һʵ֣ĳˮƽ
+struct NoiseRealisation {
+    TruthScenario scenario;
+    double measurement_noise_stddev = 0.5;
+    unsigned seed = 0;
+};
+
+struct RealisationResult {
+    ErrorStatistics observed;    // ۲ֵ
+    ErrorStatistics estimated;   // ˲ֵ
+};
+
+// ʵֵ֣۲ֻڸ߳ʱ
+std::vector<RealisationResult> runNoiseSweep(
+    const std::vector<NoiseRealisation>& realisations, double filter_process_noise_stddev,
+    TruthCache& cache, unsigned num_threads = 0)
+{
+    std::vector<RealisationResult> results(realisations.size());
+    parallelChunks(realisations.size(), 1, [&](std::size_t i, std::size_t, std::size_t) {
+        const NoiseRealisation& r = realisations[i];
+        const SharedTrajectory truth = cache.get(r.scenario);
+        PseudoRandomNormal normal(r.seed);
+        const std::vector<Point2D> observed = addMeasurementNoiseWith(*truth, r.measurement_noise_stddev, normal);
+        results[i].observed = compareTrajectories(observed, *truth);
+        results[i].estimated = evaluateFilter(*truth, observed, r.scenario.dt,
+                                              filter_process_noise_stddev, r.measurement_noise_stddev);
+    }, num_threads);
+    return results;
+}
+
+// ۲⣨OOSM۲ɱӳٵ˳ʱڵǰʱ֮ǰ
+// λ屣 window ˲գ۲ Bar-Shalom  Bl1 һ
+// ӹ۲ʱ d ĿԤ⵽ǰʱ k  (x_{k|d}, P_{k|d}) (d, k] ڵи
+// һ H=I ĵЧ۲⣬ݴ˰ѵǰ״̬ƻ d x_k  z_d ĻЭ
+// ֱǰ״̬ fastForwardCV ʽ⣬ÿ۲ֻ 4x4 㣬
+// طŴڡɿղ۲⣬ͬһڶʱǽƵ
+class OosmKalmanFilterCV {
+private:
+    struct Snapshot {
+        bool valid = false;
+        std::int64_t step = 0;
+        Vec4 x = Vec4::zero();
+        Mat4 P = Mat4::identity();
+    };
+
+    KalmanFilterCV filter;
+    std::vector<Snapshot> ring;
+    double dt;
+    double q_stddev;
+    double r_var;
+    std::int64_t step = 0;
+
+    void record()
+    {
+        Snapshot& s = ring[static_cast<std::size_t>(step) % ring.size()];
+        s.valid = true;
+        s.step = step;
+        s.x = filter.state();
+        s.P = filter.covariance();
+    }
+
+public:
+    OosmKalmanFilterCV(double dt, double process_noise_stddev, double measurement_noise_stddev,
+                       std::size_t window)
+        : filter(process_noise_stddev, measurement_noise_stddev),
+          ring(std::max<std::size_t>(window, 1)), dt(dt), q_stddev(process_noise_stddev),
+          r_var(measurement_noise_stddev * measurement_noise_stddev) {}
+
+    void init(Point2D pos, Point2D vel, double pos_var, double vel_var)
+    {
+        filter.init(pos, vel, pos_var, vel_var);
+        for (Snapshot& s : ring) s.valid = false;
+        step = 0;
+        record();
+    }
+
+    // ǰһֻԤ⣩
+    void advance()
+    {
+        filter.predict(dt);
+        ++step;
+        record();
+    }
+
+    // ǰʱ̵Ĺ۲
+    void update(Point2D z)
+    {
+        filter.update(z);
+        record();
+    }
+
+    //  measurement_step Ĺ۲⣻ڻδʱܾ false
+    bool updateDelayed(Point2D z, std::int64_t measurement_step)
+    {
+        if (measurement_step == step) {
+            update(z);
+            return true;
+        }
+        if (measurement_step < 0 || measurement_step > step ||
+            step - measurement_step >= static_cast<std::int64_t>(ring.size()))
+            return false;
+        const Snapshot& past = ring[static_cast<std::size_t>(measurement_step) % ring.size()];
+        if (!past.valid || past.step != measurement_step) return false;
+
+        const Vec4& x = filter.state();
+        const Mat4& P = filter.covariance();
+        const std::uint64_t lag = static_cast<std::uint64_t>(step - measurement_step);
+        const StepOperator<4> op = fastForwardCV(dt, q_stddev, lag);
+
+        // (d, k] ڸµĵЧ۲⣺S*^{-1} = P_{k|d}^{-1} - P_{k|d}^{-1} P_{k|k} P_{k|d}^{-1}
+        const Vec4 x_pred = op.F * past.x;
+        const Mat4 P_pred = op.F * past.P * op.F.transpose() + op.Q;
+        const Mat4 P_pred_inv = inverse(P_pred);
+        const Mat4 S_star_inv = P_pred_inv - P_pred_inv * P * P_pred_inv;
+        const Vec4 weighted_innovation = P_pred_inv * (x - x_pred);
+
+        // Ƶ dP_vv = QP_xv = Q - P_{k|d} S*^{-1} Q
+        const Mat4 back = transitionCV(-static_cast<double>(lag) * dt);
+        const Mat4 P_xv = op.Q - P_pred * S_star_inv * op.Q;
+        const Vec4 x_retro = back * (x - op.Q * weighted_innovation);
+        const Mat4 P_retro = back * (P + op.Q - P_xv - P_xv.transpose()) * back.transpose();
+
+        // x_k  z_d ĻЭ P_xz = (P_{k|k} - P_xv) F_{d,k}^T H^Tȡǰ
+        const Mat4 cross = (P - P_xv) * back.transpose();
+        Mat<4, 2> P_xz{};
+        for (int i = 0; i < 4; ++i) {
+            P_xz(i, 0) = cross(i, 0);
+            P_xz(i, 1) = cross(i, 1);
+        }
+        const Vec2 y{{{z.x - x_retro(0, 0)}, {z.y - x_retro(1, 0)}}};
+        const Mat2 S{{{P_retro(0, 0) + r_var, P_retro(0, 1)}, {P_retro(1, 0), P_retro(1, 1) + r_var}}};
+        const Mat2 S_inv = inverse(S);
+        const Mat<4, 2> W = P_xz * S_inv;
+        filter.reset(x + W * y, P - W * P_xz.transpose());
+        record();
+        return true;
+    }
+
+    std::int64_t currentStep() const { return step; }
+    Point2D position() const { return filter.position(); }
+    Point2D velocity() const { return filter.velocity(); }
+    const Vec4& state() const { return filter.state(); }
+    const Mat4& covariance() const { return filter.covariance(); }
+};
+
+// ӳٵĹ۲⣺ step ã arrival_step ͵˲
+struct DelayedMeasurement {
+    std::int64_t step;
+    std::int64_t arrival_step;
+    Point2D z;
+};
+
+// ˳۲ظڸòʱλùƣڵĹ۲ⱻ
+std::vector<Point2D> filterDelayedMeasurements(
+    std::vector<DelayedMeasurement> arrivals, std::size_t steps, double dt,
+    double process_noise_stddev, double measurement_noise_stddev, std::size_t window,
+    Point2D initial_pos)
+{
+    std::vector<Point2D> estimates;
+    if (steps == 0) return estimates;
+    estimates.reserve(steps);
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const DelayedMeasurement& a, const DelayedMeasurement& b) {
+                         return a.arrival_step < b.arrival_step;
+                     });
+
+    OosmKalmanFilterCV filter(dt, process_noise_stddev, measurement_noise_stddev, window);
+    const double r = measurement_noise_stddev * measurement_noise_stddev;
+    filter.init(initial_pos, {0.0, 0.0}, r, 100.0);
+
+    std::size_t next = 0;
+    for (std::size_t k = 0; k < steps; ++k) {
+        if (k > 0) filter.advance();
+        for (; next < arrivals.size() && arrivals[next].arrival_step <= static_cast<std::int64_t>(k); ++next)
+            filter.updateDelayed(arrivals[next].z, arrivals[next].step);
+        estimates.push_back(filter.position());
+    }
+    return estimates;
+}
+
+// Ŀ꿨˲飺N ĺ˲ṹ飨SoA
+// ģ xy  FQHR ǷֿԽǵģʼЭ޽ʱʼս
+// ÿĿֻ豣 2x2 ԳЭ 3 Ԫأ 4 ״̬˲һ
+class KalmanFilterBank {
+private:
+    struct Axis {
+        std::vector<double> pos, vel;     // ״̬
+        std::vector<double> pp, pv, vv;   // Э [pp pv; pv vv]
+
+        void resize(std::size_t n)
+        {
+            pos.assign(n, 0.0);
+            vel.assign(n, 0.0);
+            pp.assign(n, 1.0);
+            pv.assign(n, 0.0);
+            vv.assign(n, 1.0);
+        }
+
+        // ѭ޷֧޿ԪɰѶĿͬһ SIMD Ĵ
+        void predict(std::size_t n, double dt, double q)
+        {
+            double* p = pos.data();
+            double* v = vel.data();
+            double* a = pp.data();
+            double* b = pv.data();
+            double* c = vv.data();
+            const double dt2 = dt * dt;
+            for (std::size_t i = 0; i < n; ++i) {
+                p[i] += v[i] * dt;
+                a[i] += 2.0 * dt * b[i] + dt2 * c[i] + q * dt2;
+                b[i] += dt * c[i] + q * dt;
+                c[i] += q;
+            }
+        }
+
+        // mask Ϊ 0 Ŀ걾֡޹۲⣺㣬״̬ЭԤֵ
+        void update(std::size_t n, const double* z, const std::uint8_t* mask, double r)
+        {
+            double* p = pos.data();
+            double* v = vel.data();
+            double* a = pp.data();
+            double* b = pv.data();
+            double* c = vv.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const double m = mask ? static_cast<double>(mask[i] != 0) : 1.0;
+                const double inv_s = 1.0 / (a[i] + r);
+                const double k1 = m * a[i] * inv_s;
+                const double k2 = m * b[i] * inv_s;
+                const double innov = (mask && !mask[i]) ? 0.0 : z[i] - p[i];
+                p[i] += k1 * innov;
+                v[i] += k2 * innov;
+                c[i] -= k2 * b[i];
+                b[i] -= k1 * b[i];
+                a[i] -= k1 * a[i];
+            }
+        }
+    };
+
+    std::size_t count;
+    Axis ax, ay;
+    double q_var;   // ÿٶ
+    double r_var;   // 
+
+public:
+    KalmanFilterBank(std::size_t n, double process_noise_stddev, double measurement_noise_stddev)
+        : count(n),
+          q_var(process_noise_stddev * process_noise_stddev),
+          r_var(measurement_noise_stddev * measurement_noise_stddev)
+    {
+        ax.resize(n);
+        ay.resize(n);
+    }
+
+    std::size_t size() const { return count; }
+
+    void init(std::size_t i, Point2D pos, Point2D vel, double pos_var, double vel_var)
+    {
+        ax.pos[i] = pos.x;
+        ay.pos[i] = pos.y;
+        ax.vel[i] = vel.x;
+        ay.vel[i] = vel.y;
+        ax.pp[i] = ay.pp[i] = pos_var;
+        ax.pv[i] = ay.pv[i] = 0.0;
+        ax.vv[i] = ay.vv[i] = vel_var;
+    }
+
+    void predict(double dt)
+    {
+        ax.predict(count, dt, q_var);
+        ay.predict(count, dt, q_var);
+    }
+
+    // zx/zy ΪÿĿĹ۲⣨ size()mask Ϊձʾȫй۲
+    void update(const double* zx, const double* zy, const std::uint8_t* mask = nullptr)
+    {
+        ax.update(count, zx, mask, r_var);
+        ay.update(count, zy, mask, r_var);
+    }
+
+    Point2D position(std::size_t i) const { return {ax.pos[i], ay.pos[i]}; }
+    Point2D velocity(std::size_t i) const { return {ax.vel[i], ay.vel[i]}; }
+    const std::vector<double>& positionsX() const { return ax.pos; }
+    const std::vector<double>& positionsY() const { return ay.pos; }
+};
+
+// ģͣIMM˲飺ÿĿͬʱ CV٣ CAٶȣģͣ
+// ͨɷлʻϡģͳһÿ [p, v, a] ά״̬CV ģ͵ļٶȺΪ 0
+//  KalmanFilterBank һֿšĿ SoAѭĿ
+// ʱ֮ĽЭÿģڲ᱾ͽ
+class ImmFilterBank {
+public:
+    static constexpr int models = 2;   // 0 = CV1 = CA
+
+private:
+    // ״̬˲飬Эֻ 6 Ԫ
+    struct AxisBank {
+        std::vector<double> p, v, a;
+        std::vector<double> pp, pv, pa, vv, va, aa;
+        std::vector<double> loglik;   // һθµĶȻ
+
+        void resize(std::size_t n)
+        {
+            for (auto* vec : {&p, &v, &a, &pv, &pa, &va, &loglik}) vec->assign(n, 0.0);
+            for (auto* vec : {&pp, &vv, &aa}) vec->assign(n, 1.0);
+        }
+
+        // F = [1 f01 f02; 0 1 f12; 0 0 f22]Q = q g g^T
+        void predict(std::size_t n, double f01, double f02, double f12, double f22,
+                     double g0, double g1, double g2, double q)
+        {
+            for (std::size_t i = 0; i < n; ++i) {
+                const double a00 = pp[i] + f01 * pv[i] + f02 * pa[i];
+                const double a01 = pv[i] + f01 * vv[i] + f02 * va[i];
+                const double a02 = pa[i] + f01 * va[i] + f02 * aa[i];
+                const double a11 = vv[i] + f12 * va[i];
+                const double a12 = va[i] + f12 * aa[i];
+                const double a22 = f22 * aa[i];
+                pp[i] = a00 + f01 * a01 + f02 * a02 + q * g0 * g0;
+                pv[i] = a01 + f12 * a02 + q * g0 * g1;
+                pa[i] = f22 * a02 + q * g0 * g2;
+                vv[i] = a11 + f12 * a12 + q * g1 * g1;
+                va[i] = f22 * a12 + q * g1 * g2;
+                aa[i] = f22 * a22 + q * g2 * g2;
+                p[i] += f01 * v[i] + f02 * a[i];
+                v[i] += f12 * a[i];
+                a[i] *= f22;
+            }
+        }
+
+        // H = [1 0 0]
+        void update(std::size_t n, const double* z, double r)
+        {
+            constexpr double log_2pi = 1.8378770664093453;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double s = pp[i] + r;
+                const double inv_s = 1.0 / s;
+                const double k0 = pp[i] * inv_s, k1 = pv[i] * inv_s, k2 = pa[i] * inv_s;
+                const double y = z[i] - p[i];
+                loglik[i] = -0.5 * (y * y * inv_s + std::log(s) + log_2pi);
+                p[i] += k0 * y;
+                v[i] += k1 * y;
+                a[i] += k2 * y;
+                aa[i] -= k2 * pa[i];
+                va[i] -= k1 * pa[i];
+                vv[i] -= k1 * pv[i];
+                pa[i] -= k0 * pa[i];
+                pv[i] -= k0 * pv[i];
+                pp[i] -= k0 * pp[i];
+            }
+        }
+    };
+
+    std::size_t count;
+    AxisBank bank[models][2];        // [ģ][]
+    std::vector<double> mu[models];  // ģ͸
+    double transition[models][models];
+    double q[models];
+    double r_var;
+    std::vector<double> w[models][models];   // Ȩ mu_{i|j}Ԥ䣬ÿ֡䣩
+    AxisBank mixed[models];
+
+    // ϣ mu_{i|j} = p_ij mu_i / c_j Ѹģ״̬ϳÿģ͵ĳֵ
+    void mix()
+    {
+        for (std::size_t t = 0; t < count; ++t) {
+            for (int j = 0; j < models; ++j) {
+                double c = 0.0;
+                for (int i = 0; i < models; ++i) c += transition[i][j] * mu[i][t];
+                for (int i = 0; i < models; ++i) w[i][j][t] = transition[i][j] * mu[i][t] / c;
+            }
+        }
+
+        for (int axis = 0; axis < 2; ++axis) {
+            for (int j = 0; j < models; ++j) {
+                AxisBank& out = mixed[j];
+                for (std::size_t t = 0; t < count; ++t) {
+                    double p = 0.0, v = 0.0, a = 0.0;
+                    for (int i = 0; i < models; ++i) {
+                        const AxisBank& in = bank[i][axis];
+                        p += w[i][j][t] * in.p[t];
+                        v += w[i][j][t] * in.v[t];
+                        a += w[i][j][t] * in.a[t];
+                    }
+                    double pp = 0.0, pv = 0.0, pa = 0.0, vv = 0.0, va = 0.0, aa = 0.0;
+                    for (int i = 0; i < models; ++i) {
+                        const AxisBank& in = bank[i][axis];
+                        const double m = w[i][j][t];
+                        const double dp = in.p[t] - p, dv = in.v[t] - v, da = in.a[t] - a;
+                        pp += m * (in.pp[t] + dp * dp);
+                        pv += m * (in.pv[t] + dp * dv);
+                        pa += m * (in.pa[t] + dp * da);
+                        vv += m * (in.vv[t] + dv * dv);
+                        va += m * (in.va[t] + dv * da);
+                        aa += m * (in.aa[t] + da * da);
+                    }
+                    out.p[t] = p;
+                    out.v[t] = v;
+                    out.a[t] = a;
+                    out.pp[t] = pp;
+                    out.pv[t] = pv;
+                    out.pa[t] = pa;
+                    out.vv[t] = vv;
+                    out.va[t] = va;
+                    out.aa[t] = aa;
+                }
+            }
+            for (int j = 0; j < models; ++j) std::swap(bank[j][axis], mixed[j]);
+        }
+        for (int i = 0; i < models; ++i) {
+            for (std::size_t t = 0; t < count; ++t) {
+                double c = 0.0;
+                for (int k = 0; k < models; ++k) c += transition[k][i] * mu[k][t];
+                mu[i][t] = c;   // Ԥģ͸ʣºٳȻ
+            }
+        }
+    }
+
+public:
+    // cv_noiseCV ģÿٶ׼ca_noiseCA ģÿٶ׼
+    ImmFilterBank(std::size_t n, double cv_noise, double ca_noise, double measurement_noise_stddev,
+                  double stay_probability = 0.95)
+        : count(n), r_var(measurement_noise_stddev * measurement_noise_stddev)
+    {
+        q[0] = cv_noise * cv_noise;
+        q[1] = ca_noise * ca_noise;
+        for (int i = 0; i < models; ++i) {
+            for (int j = 0; j < models; ++j) {
+                transition[i][j] = (i == j) ? stay_probability : (1.0 - stay_probability) / (models - 1);
+            }
+            mu[i].assign(n, 1.0 / models);
+            bank[i][0].resize(n);
+            bank[i][1].resize(n);
+            mixed[i].resize(n);
+            for (int j = 0; j < models; ++j) w[i][j].resize(n);
+        }
+    }
+
+    std::size_t size() const { return count; }
+
+    void init(std::size_t t, Point2D pos, Point2D vel, double pos_var, double vel_var, double acc_var)
+    {
+        for (int m = 0; m < models; ++m) {
+            for (int axis = 0; axis < 2; ++axis) {
+                AxisBank& b = bank[m][axis];
+                b.p[t] = axis == 0 ? pos.x : pos.y;
+                b.v[t] = axis == 0 ? vel.x : vel.y;
+                b.a[t] = 0.0;
+                b.pp[t] = pos_var;
+                b.vv[t] = vel_var;
+                b.aa[t] = m == 0 ? 0.0 : acc_var;
+                b.pv[t] = b.pa[t] = b.va[t] = 0.0;
+            }
+            mu[m][t] = 1.0 / models;
+        }
+    }
+
+    // һ֡ -> ģԤ -> ģ͸ -> ģ͸ʸ
+    void step(double dt, const double* zx, const double* zy)
+    {
+        mix();
+        for (int axis = 0; axis < 2; ++axis) {
+            const double* z = axis == 0 ? zx : zy;
+            bank[0][axis].predict(count, dt, 0.0, 0.0, 0.0, dt, 1.0, 0.0, q[0]);
+            bank[1][axis].predict(count, dt, 0.5 * dt * dt, dt, 1.0, 0.5 * dt * dt, dt, 1.0, q[1]);
+            bank[0][axis].update(count, z, r_var);
+            bank[1][axis].update(count, z, r_var);
+        }
+        for (std::size_t t = 0; t < count; ++t) {
+            double l[models], best = -INFINITY;
+            for (int m = 0; m < models; ++m) {
+                l[m] = bank[m][0].loglik[t] + bank[m][1].loglik[t];
+                best = std::max(best, l[m]);
+            }
+            double total = 0.0;
+            for (int m = 0; m < models; ++m) {
+                mu[m][t] *= std::exp(l[m] - best);
+                total += mu[m][t];
+            }
+            for (int m = 0; m < models; ++m) mu[m][t] = std::max(mu[m][t] / total, 1e-12);
+        }
+    }
+
+    // ģ͸ʼȨۺϹ
+    Point2D position(std::size_t t) const
+    {
+        Point2D p{0.0, 0.0};
+        for (int m = 0; m < models; ++m) {
+            p.x += mu[m][t] * bank[m][0].p[t];
+            p.y += mu[m][t] * bank[m][1].p[t];
+        }
+        return p;
+    }
+
+    Point2D velocity(std::size_t t) const
+    {
+        Point2D v{0.0, 0.0};
+        for (int m = 0; m < models; ++m) {
+            v.x += mu[m][t] * bank[m][0].v[t];
+            v.y += mu[m][t] * bank[m][1].v[t];
+        }
+        return v;
+    }
+
+    double modelProbability(std::size_t t, int model) const { return mu[model][t]; }
+};
+
+// ˲˶ģ simulateWithProcessNoise ͬٶߣ
+// Ӱ SoA ţȻϵͳز̶鲢
+struct ParticleFilterConfig {
+    std::size_t initial_particles = 10000;
+    std::size_t min_particles = 1000;
+    std::size_t max_particles = 100000;
+    double resample_threshold = 0.5;   // ESS / N ڸñʱز
+    double grow_threshold = 0.1;       // ESS / N ڸñʱ
+    double shrink_threshold = 0.9;     // ESS / N ڸñʱ
+    unsigned num_threads = 0;
+};
+
+class ParticleFilter {
+private:
+    static constexpr std::size_t chunk_size = 2048;
+
+    ParticleFilterConfig config;
+    double q_stddev;   // ׼ÿٶ
+    double r_var;      // 
+    unsigned seed;
+    std::uint64_t step = 0;
+
+    std::vector<double> px, py, vx, vy, w;  // w ΪһȨ
+    std::vector<double> nx, ny, nvx, nvy;   // زĿ껺
+    double ess = 0.0;
+
+    std::size_t chunkCount() const { return (px.size() + chunk_size - 1) / chunk_size; }
+
+    // ÿÿ棬߳޹
+    std::default_random_engine engineFor(std::size_t chunk, unsigned stream) const
+    {
+        std::seed_seq seq{seed, static_cast<unsigned>(step), static_cast<unsigned>(step >> 32),
+                          static_cast<unsigned>(chunk), stream};
+        return std::default_random_engine(seq);
+    }
+
+    //  w еĶȨعһΪȨأΪ 1ͬʱЧ
+    void normalizeWeights()
+    {
+        const std::size_t n = px.size();
+        const std::size_t chunks = chunkCount();
+        std::vector<double> partial(chunks);
+
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            double m = -INFINITY;
+            for (std::size_t i = begin; i < end; ++i) m = std::max(m, w[i]);
+            partial[c] = m;
+        }, config.num_threads);
+        const double max_logw = *std::max_element(partial.begin(), partial.end());
+
+        std::vector<double> sq(chunks);
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            double sum = 0.0, sum_sq = 0.0;
+            for (std::size_t i = begin; i < end; ++i) {
+                const double wi = std::exp(w[i] - max_logw);
+                w[i] = wi;
+                sum += wi;
+                sum_sq += wi * wi;
+            }
+            partial[c] = sum;
+            sq[c] = sum_sq;
+        }, config.num_threads);
+
+        double total = 0.0, total_sq = 0.0;
+        for (std::size_t c = 0; c < chunks; ++c) {
+            total += partial[c];
+            total_sq += sq[c];
+        }
+        const double inv = 1.0 / total;
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t i = begin; i < end; ++i) w[i] *= inv;
+        }, config.num_threads);
+        ess = total * total / total_sq;
+    }
+
+    // ϵͳز m ӣھֲǰ׺ + ƫƵõȫۻȨأ
+    //  i ĸд [ceil(m*C_{i-1} - u), ceil(m*C_i - u))黥ͻ
+    void resample(std::size_t m)
+    {
+        const std::size_t n = px.size();
+        const std::size_t chunks = chunkCount();
+        std::vector<double> chunk_sum(chunks);
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            double sum = 0.0;
+            for (std::size_t i = begin; i < end; ++i) sum += w[i];
+            chunk_sum[c] = sum;
+        }, config.num_threads);
+
+        std::vector<double> chunk_offset(chunks);
+        double running = 0.0;
+        for (std::size_t c = 0; c < chunks; ++c) {
+            chunk_offset[c] = running;
+            running += chunk_sum[c];
+        }
+
+        auto engine = engineFor(0, 1);
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(engine);
+        const double scale = static_cast<double>(m) / running;
+        auto startIndex = [&](double cumulative) {
+            const double s = std::ceil(cumulative * scale - u);
+            return static_cast<std::size_t>(std::clamp(s, 0.0, static_cast<double>(m)));
+        };
+
+        nx.resize(m);
+        ny.resize(m);
+        nvx.resize(m);
+        nvy.resize(m);
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            // յһȡͬһ chunk_offsetۼӵ
+            // ڿ֮Ŀնص
+            double cumulative = chunk_offset[c];
+            std::size_t out = startIndex(cumulative);
+            const std::size_t chunk_stop = (c + 1 == chunks) ? m : startIndex(chunk_offset[c + 1]);
+            for (std::size_t i = begin; i < end; ++i) {
+                cumulative += w[i];
+                const std::size_t stop = (i + 1 == end) ? chunk_stop : std::min(startIndex(cumulative), chunk_stop);
+                for (; out < stop; ++out) {
+                    nx[out] = px[i];
+                    ny[out] = py[i];
+                    nvx[out] = vx[i];
+                    nvy[out] = vy[i];
+                }
+            }
+        }, config.num_threads);
+
+        px.swap(nx);
+        py.swap(ny);
+        vx.swap(nvx);
+        vy.swap(nvy);
+        w.assign(m, 1.0 / static_cast<double>(m));
+        ess = static_cast<double>(m);
+    }
+
+public:
+    ParticleFilter(double process_noise_stddev, double measurement_noise_stddev,
+                   ParticleFilterConfig cfg = {}, unsigned seed = std::random_device{}())
+        : config(cfg), q_stddev(process_noise_stddev),
+          r_var(measurement_noise_stddev * measurement_noise_stddev), seed(seed) {}
+
+    void init(Point2D pos, Point2D vel, double pos_stddev, double vel_stddev)
+    {
+        const std::size_t n = config.initial_particles;
+        px.resize(n);
+        py.resize(n);
+        vx.resize(n);
+        vy.resize(n);
+        w.assign(n, 1.0 / static_cast<double>(n));
+        parallelChunks(n, chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            auto engine = engineFor(c, 0);
+            std::normal_distribution<double> dp(0.0, pos_stddev), dv(0.0, vel_stddev);
+            for (std::size_t i = begin; i < end; ++i) {
+                px[i] = pos.x + dp(engine);
+                py[i] = pos.y + dp(engine);
+                vx[i] = vel.x + dv(engine);
+                vy[i] = vel.y + dv(engine);
+            }
+        }, config.num_threads);
+        ess = static_cast<double>(n);
+    }
+
+    // ״̬ѭ
+    void predict(double dt)
+    {
+        ++step;
+        parallelChunks(px.size(), chunk_size, [&](std::size_t begin, std::size_t end, std::size_t c) {
+            auto engine = engineFor(c, 0);
+            std::normal_distribution<double> process_noise(0.0, q_stddev);
+            double noise[2 * chunk_size];
+            const std::size_t len = end - begin;
+            for (std::size_t k = 0; k < 2 * len; ++k) noise[k] = process_noise(engine);
+            for (std::size_t k = 0; k < len; ++k) {
+                const std::size_t i = begin + k;
+                vx[i] += noise[2 * k];
+                vy[i] += noise[2 * k + 1];
+                px[i] += vx[i] * dt;
+                py[i] += vy[i] * dt;
+            }
+        }, config.num_threads);
+    }
+
+    // ȻڶۼӣԶ۲ʱȨ
+    void update(Point2D z)
+    {
+        const double inv_2r = 0.5 / r_var;
+        parallelChunks(px.size(), chunk_size, [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const double dx = px[i] - z.x;
+                const double dy = py[i] - z.y;
+                w[i] = std::log(w[i]) - (dx * dx + dy * dy) * inv_2r;
+            }
+        }, config.num_threads);
+        normalizeWeights();
+
+        // Ӧ˻ʱӱȨغܾʱ
+        const double n = static_cast<double>(px.size());
+        const double ratio = ess / n;
+        if (ratio < config.grow_threshold) {
+            resample(std::min(config.max_particles, px.size() * 2));
+        } else if (ratio < config.resample_threshold) {
+            resample(px.size());
+        } else if (ratio > config.shrink_threshold && px.size() / 2 >= config.min_particles) {
+            resample(px.size() / 2);
+        }
+    }
+
+    // ȨֵǰȨؾѹһ
+    Point2D estimate() const
+    {
+        double ex = 0.0, ey = 0.0;
+        for (std::size_t i = 0; i < px.size(); ++i) {
+            ex += w[i] * px[i];
+            ey += w[i] * py[i];
+        }
+        return {ex, ey};
+    }
+
+    double effectiveSampleSize() const { return ess; }
+    std::size_t particleCount() const { return px.size(); }
+};
+
+// 㣺 + οa = -k|v|v - gRK4 µĵ
+struct ProjectileParams {
+    double muzzle_speed = 25.0;   // ٶȣm/s
+    double drag_coeff = 0.01;     // ϵ k1/m
+    double gravity = 9.81;
+    double step = 1e-3;           // ֲ룩
+    double max_time = 5.0;        // ʱ
+};
+
+//  pitchȣ䣬ɵˮƽ distance ʱĸ߶Ⱥͷʱ䣻򲻵 false
+bool flyToDistance(const ProjectileParams& params, double pitch, double distance, double& height, double& tof)
+{
+    struct State { double x, y, vx, vy; };
+    auto deriv = [&](const State& s) {
+        const double speed = std::sqrt(s.vx * s.vx + s.vy * s.vy);
+        return State{s.vx, s.vy, -params.drag_coeff * speed * s.vx,
+                     -params.drag_coeff * speed * s.vy - params.gravity};
+    };
+    auto axpy = [](const State& s, double h, const State& d) {
+        return State{s.x + h * d.x, s.y + h * d.y, s.vx + h * d.vx, s.vy + h * d.vy};
+    };
+
+    State s{0.0, 0.0, params.muzzle_speed * std::cos(pitch), params.muzzle_speed * std::sin(pitch)};
+    const double h = params.step;
+    for (double t = 0.0; t < params.max_time; t += h) {
+        const State k1 = deriv(s);
+        const State k2 = deriv(axpy(s, 0.5 * h, k1));
+        const State k3 = deriv(axpy(s, 0.5 * h, k2));
+        const State k4 = deriv(axpy(s, h, k3));
+        const State next{s.x + h / 6.0 * (k1.x + 2.0 * k2.x + 2.0 * k3.x + k4.x),
+                         s.y + h / 6.0 * (k1.y + 2.0 * k2.y + 2.0 * k3.y + k4.y),
+                         s.vx + h / 6.0 * (k1.vx + 2.0 * k2.vx + 2.0 * k3.vx + k4.vx),
+                         s.vy + h / 6.0 * (k1.vy + 2.0 * k2.vy + 2.0 * k3.vy + k4.vy)};
+        if (next.x >= distance) {
+            const double f = (distance - s.x) / (next.x - s.x);
+            height = s.y + f * (next.y - s.y);
+            tof = t + f * h;
+            return true;
+        }
+        if (next.vx <= 0.0) return false;
+        s = next;
+    }
+    return false;
+}
+
+//  (distance, height) ĵ͵ǣȴɨҵΧ䣬ٶ
+// ͵ڵ߶温ǵ
+bool solvePitch(const ProjectileParams& params, double distance, double height, double& pitch, double& tof)
+{
+    constexpr double deg = M_PI / 180.0;
+    double lo = -60.0 * deg, lo_h = 0.0, t = 0.0;
+    if (!flyToDistance(params, lo, distance, lo_h, t) || lo_h > height) return false;
+
+    double hi = lo, hi_h = lo_h;
+    for (double a = lo + 5.0 * deg; a <= 80.0 * deg; a += 5.0 * deg) {
+        double ah;
+        if (!flyToDistance(params, a, distance, ah, t) || ah < hi_h) return false;  // Խߵδﵽ
+        lo = hi;
+        lo_h = hi_h;
+        hi = a;
+        hi_h = ah;
+        if (ah >= height) break;
+    }
+    if (hi_h < height) return false;
+
+    for (int iter = 0; iter < 30; ++iter) {
+        const double mid = 0.5 * (lo + hi);
+        double mh;
+        if (!flyToDistance(params, mid, distance, mh, t)) return false;
+        if (mh < height) lo = mid;
+        else hi = mid;
+    }
+    pitch = 0.5 * (lo + hi);
+    double h;
+    return flyToDistance(params, pitch, distance, h, tof);
+}
+
+// Ԥĸ/ʱұ x ߶ȣѯʱ˫Բֵ
+// ÿ֡ѯֻ輸γ˼ӣٵ֣ɴĸ NaN
+class BallisticTable {
+private:
+    ProjectileParams params;
+    double d_min = 0.0, d_step = 1.0, h_min = 0.0, h_step = 1.0;
+    std::size_t nd = 0, nh = 0;
+    std::vector<double> pitch_table, tof_table;   // [h][d]
+
+public:
+    BallisticTable(const ProjectileParams& p,
+                   double distance_min, double distance_max, std::size_t distance_count,
+                   double height_min, double height_max, std::size_t height_count,
+                   unsigned num_threads = 0)
+        : params(p), d_min(distance_min), h_min(height_min), nd(distance_count), nh(height_count),
+          pitch_table(distance_count * height_count), tof_table(distance_count * height_count)
+    {
+        if (distance_count < 2 || height_count < 2 || distance_max <= distance_min || height_max <= height_min) {
+            throw std::invalid_argument("ұΧЧ");
+        }
+        d_step = (distance_max - distance_min) / static_cast<double>(nd - 1);
+        h_step = (height_max - height_min) / static_cast<double>(nh - 1);
+
+        parallelChunks(nh, 1, [&](std::size_t row, std::size_t, std::size_t) {
+            for (std::size_t j = 0; j < nd; ++j) {
+                double pitch = NAN, tof = NAN;
+                if (!solvePitch(params, d_min + j * d_step, h_min + row * h_step, pitch, tof)) {
+                    pitch = tof = NAN;
+                }
+                pitch_table[row * nd + j] = pitch;
+                tof_table[row * nd + j] = tof;
+            }
+        }, num_threads);
+    }
+
+    // ΧΧвɴʱ false
+    bool lookup(double distance, double height, double& pitch, double& tof) const
+    {
+        const double fd = (distance - d_min) / d_step;
+        const double fh = (height - h_min) / h_step;
+        if (!(fd >= 0.0 && fh >= 0.0 && fd <= nd - 1 && fh <= nh - 1)) return false;
+
+        const std::size_t j = std::min(static_cast<std::size_t>(fd), nd - 2);
+        const std::size_t i = std::min(static_cast<std::size_t>(fh), nh - 2);
+        const double u = fd - j;
+        const double v = fh - i;
+        auto bilinear = [&](const std::vector<double>& t) {
+            const double* r0 = &t[i * nd + j];
+            const double* r1 = r0 + nd;
+            return (1.0 - v) * ((1.0 - u) * r0[0] + u * r0[1]) + v * ((1.0 - u) * r1[0] + u * r1[1]);
+        };
+        pitch = bilinear(pitch_table);
+        tof = bilinear(tof_table);
+        return !std::isnan(pitch) && !std::isnan(tof);
+    }
+
+    const ProjectileParams& projectile() const { return params; }
+};
+
+// ӳٲԤ׼Ŀ״̬ڵƽڣλԭ㣩
+// ӵʱΪ now + latencyʱټϷʱ
+struct AimSolution {
+    Point2D intercept{0.0, 0.0};   // е
+    double yaw = 0.0;              // ˮƽλǣȣ
+    double pitch = 0.0;            // ǣȣʱЧ
+    double time_of_flight = 0.0;
+    int iterations = 0;
+    bool valid = false;
+};
+
+// Ŀ + ٵıʽ⣺|p + v (L + t)| = s tչΪ t ĶηȡС
+AimSolution solveInterceptConstantVelocity(Point2D pos, Point2D vel, double latency, double projectile_speed)
+{
+    AimSolution sol;
+    const Point2D p{pos.x + vel.x * latency, pos.y + vel.y * latency};
+    const double a = vel.x * vel.x + vel.y * vel.y - projectile_speed * projectile_speed;
+    const double b = 2.0 * (p.x * vel.x + p.y * vel.y);
+    const double c = p.x * p.x + p.y * p.y;
+
+    double t = -1.0;
+    if (std::fabs(a) < 1e-12) {
+        if (b < 0.0) t = -c / b;
+    } else {
+        const double disc = b * b - 4.0 * a * c;
+        if (disc >= 0.0) {
+            const double sq = std::sqrt(disc);
+            const double t1 = (-b - sq) / (2.0 * a);
+            const double t2 = (-b + sq) / (2.0 * a);
+            const double lo = std::min(t1, t2), hi = std::max(t1, t2);
+            t = lo > 0.0 ? lo : hi;
+        }
+    }
+    if (t <= 0.0) return sol;
+
+    sol.time_of_flight = t;
+    sol.intercept = {p.x + vel.x * t, p.y + vel.y * t};
+    sol.yaw = std::atan2(sol.intercept.y, sol.intercept.x);
+    sol.valid = true;
+    return sol;
+}
+
+// һΣٶĿꡢн粻
+// t_{k+1} = TOF(|p(L + t_k)|)ʱ͸ BallisticTable ȫ޶ѷ
+AimSolution solveInterceptBallistic(const BallisticTable& table, Point2D pos, Point2D vel, Point2D acc,
+                                    double target_height, double latency,
+                                    int max_iterations = 8, double tolerance = 1e-5)
+{
+    AimSolution sol;
+    auto predict = [&](double tau) {
+        return Point2D{pos.x + vel.x * tau + 0.5 * acc.x * tau * tau,
+                       pos.y + vel.y * tau + 0.5 * acc.y * tau * tau};
+    };
+
+    double t = 0.0;
+    for (int k = 1; k <= max_iterations; ++k) {
+        const Point2D p = predict(latency + t);
+        double pitch, tof;
+        if (!table.lookup(std::sqrt(p.x * p.x + p.y * p.y), target_height, pitch, tof)) return sol;
+
+        sol.iterations = k;
+        sol.intercept = p;
+        sol.pitch = pitch;
+        sol.time_of_flight = tof;
+        if (std::fabs(tof - t) < tolerance) {
+            sol.valid = true;
+            break;
+        }
+        t = tof;
+    }
+    sol.yaw = std::atan2(sol.intercept.y, sol.intercept.x);
+    return sol;
+}
+
+// Ŀݹ + ϡ·
+// ߳Сް뾶ÿֻڸ 8 ڵĹ۲⣬
+// ֻڵ (, ۲) Խϡ۱
+class SpatialGrid {
+private:
+    double min_x = 0.0, min_y = 0.0, cell = 1.0;
+    long nx = 0, ny = 0;
+    std::vector<std::size_t> cell_start;   // CSRÿ items еʼλ
+    std::vector<int> items;
+
+    long cellX(double x) const { return static_cast<long>((x - min_x) / cell); }
+    long cellY(double y) const { return static_cast<long>((y - min_y) / cell); }
+
+public:
+    SpatialGrid(const std::vector<Point2D>& points, double min_cell_size)
+    {
+        if (points.empty()) return;
+        double max_x = points[0].x, max_y = points[0].y;
+        min_x = max_x;
+        min_y = max_y;
+        for (const auto& p : points) {
+            min_x = std::min(min_x, p.x);
+            min_y = std::min(min_y, p.y);
+            max_x = std::max(max_x, p.x);
+            max_y = std::max(max_y, p.y);
+        }
+        // ڵ 4 ڣϡʱŴ
+        cell = std::max(min_cell_size, 1e-9);
+        const double max_cells = 4.0 * static_cast<double>(points.size()) + 16.0;
+        while (((max_x - min_x) / cell + 1.0) * ((max_y - min_y) / cell + 1.0) > max_cells) cell *= 2.0;
+        nx = cellX(max_x) + 1;
+        ny = cellY(max_y) + 1;
+
+        //  CSR
+        cell_start.assign(static_cast<std::size_t>(nx * ny) + 1, 0);
+        for (const auto& p : points) ++cell_start[cellY(p.y) * nx + cellX(p.x) + 1];
+        for (std::size_t c = 1; c < cell_start.size(); ++c) cell_start[c] += cell_start[c - 1];
+        items.resize(points.size());
+        std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            items[fill[cellY(points[i].y) * nx + cellX(points[i].x)]++] = static_cast<int>(i);
+        }
+    }
+
+    //  q Χ 3x3 ڵÿ visit(index)
+    template <typename Visit>
+    void forEachNear(Point2D q, Visit visit) const
+    {
+        if (items.empty()) return;
+        const long cx = static_cast<long>(std::floor((q.x - min_x) / cell));
+        const long cy = static_cast<long>(std::floor((q.y - min_y) / cell));
+        for (long y = std::max(0L, cy - 1); y <= std::min(ny - 1, cy + 1); ++y) {
+            for (long x = std::max(0L, cx - 1); x <= std::min(nx - 1, cx + 1); ++x) {
+                const std::size_t c = static_cast<std::size_t>(y * nx + x);
+                for (std::size_t k = cell_start[c]; k < cell_start[c + 1]; ++k) visit(items[k]);
+            }
+        }
+    }
+};
+
+struct Association {
+    std::vector<int> track_to_measurement;   // -1 ʾú֡޹۲
+    std::vector<int> measurement_to_track;   // -1 ʾĿӲ
+    double total_cost = 0.0;                 // ѹԵľƽ֮
+};
+
+// ϡ·䣨Jonker-Volgenant ʽ Dijkstra  + ƣ
+// ۰ CSR ţֻڵıߡ룬ӸгԼ Dijkstra
+// һмǰ㣬ֻ±ɨơ
+// ͼ·̣ͨܶÿֻУܴԣ
+// ֻдƬĿ껥༷ʱŻɢƬ
+std::vector<int> solveSparseAssignment(int rows, int cols, const std::vector<std::size_t>& row_start,
+                                       const std::vector<int>& col_index, const std::vector<double>& cost)
+{
+    std::vector<double> v(cols, 0.0), dist(cols, INFINITY), pred_cost(cols, 0.0), matched_cost(rows, 0.0);
+    std::vector<int> col_to_row(cols, -1), row_to_col(rows, -1), pred(cols, -1);
+    std::vector<char> scanned(cols, 0);
+    std::vector<int> touched, ready;
+    using Item = std::pair<double, int>;
+    std::vector<Item> heap;
+
+    for (int s = 0; s < rows; ++s) {
+        if (row_start[s] == row_start[s + 1]) continue;
+        touched.clear();
+        ready.clear();
+        heap.clear();
+        // base Ϊ i ľȥеĶżֵ
+        auto relax = [&](int i, double base) {
+            for (std::size_t e = row_start[i]; e < row_start[i + 1]; ++e) {
+                const int k = col_index[e];
+                if (scanned[k]) continue;
+                const double nd = base + cost[e] - v[k];
+                if (nd < dist[k]) {
+                    if (dist[k] == INFINITY) touched.push_back(k);
+                    dist[k] = nd;
+                    pred[k] = i;
+                    pred_cost[k] = cost[e];
+                    heap.push_back({nd, k});
+                    std::push_heap(heap.begin(), heap.end(), std::greater<Item>());
+                }
+            }
+        };
+        relax(s, 0.0);
+
+        int sink = -1;
+        double reach = 0.0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Item>());
+            const auto [d, j] = heap.back();
+            heap.pop_back();
+            if (scanned[j] || d > dist[j]) continue;
+            if (col_to_row[j] < 0) {
+                sink = j;
+                reach = d;
+                break;
+            }
+            scanned[j] = 1;
+            ready.push_back(j);
+            const int i = col_to_row[j];
+            relax(i, d - (matched_cost[i] - v[j]));
+        }
+
+        if (sink >= 0) {
+            for (int j : ready) v[j] += dist[j] - reach;
+            for (int j = sink;;) {
+                const int i = pred[j];
+                const int next = row_to_col[i];
+                col_to_row[j] = i;
+                row_to_col[i] = j;
+                matched_cost[i] = pred_cost[j];
+                if (i == s) break;
+                j = next;
+            }
+        }
+        for (int k : touched) {
+            dist[k] = INFINITY;
+            scanned[k] = 0;
+        }
+    }
+    return row_to_col;
+}
+
+// ÿһֻԼġ©족УΪ gate^2ÿɹ
+// ĶԲ۱
+Association associateMeasurements(const std::vector<Point2D>& tracks,
+                                  const std::vector<Point2D>& measurements, double gate_radius)
+{
+    const double gate2 = gate_radius * gate_radius;
+    const std::size_t nt = tracks.size();
+    const std::size_t nm = measurements.size();
+
+    // ˳ռڵıߣĩβ׷©Ук nm + t CSR
+    std::vector<std::size_t> row_start(nt + 1, 0);
+    std::vector<int> col_index;
+    std::vector<double> cost;
+    SpatialGrid grid(measurements, gate_radius);
+    for (std::size_t t = 0; t < nt; ++t) {
+        const std::size_t first = col_index.size();
+        grid.forEachNear(tracks[t], [&](int m) {
+            const double dx = measurements[m].x - tracks[t].x;
+            const double dy = measurements[m].y - tracks[t].y;
+            const double d2 = dx * dx + dy * dy;
+            if (d2 <= gate2) {
+                col_index.push_back(m);
+                cost.push_back(d2);
+            }
+        });
+        // ûкѡ۲ĺ
+        if (col_index.size() > first) {
+            col_index.push_back(static_cast<int>(nm + t));
+            cost.push_back(gate2);
+        }
+        row_start[t + 1] = col_index.size();
+    }
+
+    Association result;
+    result.track_to_measurement.assign(nt, -1);
+    result.measurement_to_track.assign(nm, -1);
+    const std::vector<int> row_to_col =
+        solveSparseAssignment(static_cast<int>(nt), static_cast<int>(nm + nt), row_start, col_index, cost);
+    for (std::size_t t = 0; t < nt; ++t) {
+        const int col = row_to_col[t];
+        if (col < 0 || col >= static_cast<int>(nm)) continue;
+        result.track_to_measurement[t] = col;
+        result.measurement_to_track[col] = static_cast<int>(t);
+        for (std::size_t e = row_start[t]; e < row_start[t + 1]; ++e) {
+            if (col_index[e] == col) {
+                result.total_cost += cost[e];
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+// ʽ켣ѹѹ룬ɱ߱룻ģʽ
+//  - 𣺰 2*max_error öԤ⣨˶²вӽ 0zigzag + varint max_error
+//  - Ԥֵλȥβֽڣֽڼ¼βֽЧֽ
+// ߶ֽڶ룬ʱֱд x/y ֿ SoA 
+enum class CompressionMode : std::uint8_t { Lossless = 0, Quantized = 1 };
+
+class TrajectoryCompressor {
+private:
+    CompressionMode mode;
+    double quantum;   // ģʽ
+    std::vector<std::uint8_t> out;
+    std::uint64_t samples = 0;
+    std::int64_t q1[2] = {0, 0}, q2[2] = {0, 0};   // ǰֵ
+    double p1[2] = {0.0, 0.0}, p2[2] = {0.0, 0.0}; // ǰԭʼֵ
+
+    void putVarint(std::uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    void putQuantized(int axis, double value)
+    {
+        const std::int64_t q = std::llround(value / quantum);
+        const std::int64_t pred = samples >= 2 ? 2 * q1[axis] - q2[axis] : (samples == 1 ? q1[axis] : 0);
+        const std::int64_t r = q - pred;
+        putVarint((static_cast<std::uint64_t>(r) << 1) ^ static_cast<std::uint64_t>(r >> 63));   // zigzag
+        q2[axis] = q1[axis];
+        q1[axis] = q;
+    }
+
+    void putXor(int axis, double value)
+    {
+        const double pred = samples >= 2 ? 2.0 * p1[axis] - p2[axis] : (samples == 1 ? p1[axis] : 0.0);
+        std::uint64_t a, b;
+        std::memcpy(&a, &value, 8);
+        std::memcpy(&b, &pred, 8);
+        const std::uint64_t x = a ^ b;
+        int tz = 0, lz = 0;
+        if (x != 0) {
+            while (((x >> (8 * tz)) & 0xFF) == 0) ++tz;
+            while (((x >> (8 * (7 - lz))) & 0xFF) == 0) ++lz;
+        }
+        const int n = x == 0 ? 0 : 8 - tz - lz;
+        out.push_back(static_cast<std::uint8_t>((tz << 4) | n));
+        for (int k = 0; k < n; ++k) out.push_back(static_cast<std::uint8_t>(x >> (8 * (tz + k))));
+        p2[axis] = p1[axis];
+        p1[axis] = value;
+    }
+
+public:
+    // max_error Ϊ 0 ʱʹģʽ
+    explicit TrajectoryCompressor(double max_error = 0.0)
+        : mode(max_error > 0.0 ? CompressionMode::Quantized : CompressionMode::Lossless),
+          quantum(2.0 * max_error)
+    {
+        out.push_back(static_cast<std::uint8_t>(mode));
+        const std::uint8_t* q = reinterpret_cast<const std::uint8_t*>(&quantum);
+        out.insert(out.end(), q, q + sizeof(double));
+    }
+
+    // ģʽҪֵ |v / quantum| < 2^60Ԥв int64
+    // Χ NaNʱ׳쳣òдκֽڣ÷ɸģʽ
+    void push(Point2D p)
+    {
+        if (mode == CompressionMode::Quantized) {
+            constexpr double limit = 1152921504606846976.0;   // 2^60
+            if (!(std::fabs(p.x / quantum) < limit) || !(std::fabs(p.y / quantum) < limit)) {
+                throw std::out_of_range("ѹıʾΧ max_error ʹģʽ");
+            }
+            putQuantized(0, p.x);
+            putQuantized(1, p.y);
+        } else {
+            putXor(0, p.x);
+            putXor(1, p.y);
+        }
+        ++samples;
+    }
+
+    void push(const std::vector<Point2D>& points)
+    {
+        for (const auto& p : points) push(p);
+    }
+
+    std::uint64_t size() const { return samples; }
+    const std::vector<std::uint8_t>& bytes() const { return out; }
+};
+
+// ȫ׷ӵ xs / ys
+void decompressTrajectory(const std::vector<std::uint8_t>& bytes, std::vector<double>& xs, std::vector<double>& ys)
+{
+    if (bytes.size() < 1 + sizeof(double) || bytes[0] > 1) {
+        throw std::invalid_argument("ѹͷЧ");
+    }
+    const CompressionMode mode = static_cast<CompressionMode>(bytes[0]);
+    double quantum;
+    std::memcpy(&quantum, bytes.data() + 1, sizeof(double));
+
+    const std::uint8_t* p = bytes.data() + 1 + sizeof(double);
+    const std::uint8_t* end = bytes.data() + bytes.size();
+    auto fail = []() { throw std::invalid_argument("ѹݱض"); };
+
+    std::uint64_t samples = 0;
+    if (mode == CompressionMode::Quantized) {
+        std::int64_t q1[2] = {0, 0}, q2[2] = {0, 0};
+        while (p < end) {
+            double v[2];
+            for (int axis = 0; axis < 2; ++axis) {
+                std::uint64_t z = 0;
+                int shift = 0;
+                for (;;) {
+                    if (p == end || shift > 63) fail();
+                    const std::uint8_t b = *p++;
+                    z |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                    if (!(b & 0x80)) break;
+                    shift += 7;
+                }
+                const std::int64_t r = static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1);
+                const std::int64_t pred = samples >= 2 ? 2 * q1[axis] - q2[axis] : (samples == 1 ? q1[axis] : 0);
+                const std::int64_t q = pred + r;
+                q2[axis] = q1[axis];
+                q1[axis] = q;
+                v[axis] = static_cast<double>(q) * quantum;
+            }
+            xs.push_back(v[0]);
+            ys.push_back(v[1]);
+            ++samples;
+        }
+    } else {
+        double p1[2] = {0.0, 0.0}, p2[2] = {0.0, 0.0};
+        while (p < end) {
+            double v[2];
+            for (int axis = 0; axis < 2; ++axis) {
+                if (p == end) fail();
+                const int tz = *p >> 4, n = *p & 0x0F;
+                ++p;
+                if (n > 8 || end - p < n) fail();
+                std::uint64_t x = 0;
+                for (int k = 0; k < n; ++k) x |= static_cast<std::uint64_t>(*p++) << (8 * (tz + k));
+                const double pred = samples >= 2 ? 2.0 * p1[axis] - p2[axis] : (samples == 1 ? p1[axis] : 0.0);
+                std::uint64_t bits;
+                std::memcpy(&bits, &pred, 8);
+                bits ^= x;
+                std::memcpy(&v[axis], &bits, 8);
+                p2[axis] = p1[axis];
+                p1[axis] = v[axis];
+            }
+            xs.push_back(v[0]);
+            ys.push_back(v[1]);
+            ++samples;
+        }
+    }
+}
+
+// ʱ̲ѯ켣λãȲʱ O(1) ±꣬ǾȲʱֲң
+// ֧Բֵ Hermite ֵȡڲ޲֣Χʱȡ˵
+enum class Interpolation { Linear, Cubic };
+
+class TimedTrajectory {
+private:
+    std::vector<double> xs, ys;   // SoAѯ
+    std::vector<double> times;    // ǾȲʱ̣ȲʱΪ
+    double t0 = 0.0;
+    double dt = 0.0;
+
+    //  t  [k, k+1] ڱ u
+    void locate(double t, std::size_t& k, double& u) const
+    {
+        const std::size_t n = xs.size();
+        if (times.empty()) {
+            const double f = std::clamp((t - t0) / dt, 0.0, static_cast<double>(n - 1));
+            k = std::min(static_cast<std::size_t>(f), n - 2);
+            u = f - static_cast<double>(k);
+            return;
+        }
+        if (t <= times.front()) {
+            k = 0;
+            u = 0.0;
+            return;
+        }
+        if (t >= times.back()) {
+            k = n - 2;
+            u = 1.0;
+            return;
+        }
+        k = static_cast<std::size_t>(std::upper_bound(times.begin(), times.end(), t) - times.begin()) - 1;
+        u = (t - times[k]) / (times[k + 1] - times[k]);
+    }
+
+    double timeOf(std::size_t k) const { return times.empty() ? t0 + k * dt : times[k]; }
+
+    //  k ʱĵĲ֣˵õ֣
+    double slope(const std::vector<double>& v, std::size_t k) const
+    {
+        const std::size_t a = k > 0 ? k - 1 : k;
+        const std::size_t b = std::min(k + 1, v.size() - 1);
+        return (v[b] - v[a]) / (timeOf(b) - timeOf(a));
+    }
+
+    double cubic(const std::vector<double>& v, std::size_t k, double u) const
+    {
+        const double h = timeOf(k + 1) - timeOf(k);
+        const double u2 = u * u, u3 = u2 * u;
+        return (2 * u3 - 3 * u2 + 1) * v[k] + (u3 - 2 * u2 + u) * h * slope(v, k) +
+               (-2 * u3 + 3 * u2) * v[k + 1] + (u3 - u2) * h * slope(v, k + 1);
+    }
+
+public:
+    // Ȳ i ʱΪ t0 + i * dt main  i * dt һ£
+    TimedTrajectory(const std::vector<Point2D>& points, double dt, double t0 = 0.0) : t0(t0), dt(dt)
+    {
+        if (points.size() < 2 || dt <= 0.0) {
+            throw std::invalid_argument("Ҫ dt Ϊ");
+        }
+        for (const auto& p : points) {
+            xs.push_back(p.x);
+            ys.push_back(p.y);
+        }
+    }
+
+    // ǾȲtimes ϸ
+    TimedTrajectory(const std::vector<Point2D>& points, std::vector<double> sample_times)
+        : times(std::move(sample_times))
+    {
+        if (points.size() < 2 || points.size() != times.size()) {
+            throw std::invalid_argument("ʱһ");
+        }
+        for (std::size_t i = 1; i < times.size(); ++i) {
+            if (!(times[i] > times[i - 1])) {
+                throw std::invalid_argument("ʱ̱ϸ");
+            }
+        }
+        for (const auto& p : points) {
+            xs.push_back(p.x);
+            ys.push_back(p.y);
+        }
+    }
+
+    Point2D at(double t, Interpolation mode = Interpolation::Linear) const
+    {
+        std::size_t k;
+        double u;
+        locate(t, k, u);
+        if (mode == Interpolation::Cubic) return {cubic(xs, k, u), cubic(ys, k, u)};
+        return {xs[k] + u * (xs[k + 1] - xs[k]), ys[k] + u * (ys[k + 1] - ys[k])};
+    }
+
+    // ѯȲ + Բֵʱȫ±Ȩأ޷֧ռ-ֵѭ
+    void evaluate(const double* query_times, std::size_t n, double* out_x, double* out_y,
+                  Interpolation mode = Interpolation::Linear) const
+    {
+        if (!times.empty() || mode != Interpolation::Linear) {
+            for (std::size_t i = 0; i < n; ++i) {
+                const Point2D p = at(query_times[i], mode);
+                out_x[i] = p.x;
+                out_y[i] = p.y;
+            }
+            return;
+        }
+        constexpr std::size_t block = 256;
+        std::size_t idx[block];
+        double w[block];
+        const double last = static_cast<double>(xs.size() - 1);
+        const double inv_dt = 1.0 / dt;
+        const double* x = xs.data();
+        const double* y = ys.data();
+        for (std::size_t base = 0; base < n; base += block) {
+            const std::size_t m = std::min(block, n - base);
+            for (std::size_t i = 0; i < m; ++i) {
+                const double f = std::min(std::max((query_times[base + i] - t0) * inv_dt, 0.0), last);
+                const std::size_t k = std::min(static_cast<std::size_t>(f), xs.size() - 2);
+                idx[i] = k;
+                w[i] = f - static_cast<double>(k);
+            }
+            for (std::size_t i = 0; i < m; ++i) {
+                const std::size_t k = idx[i];
+                out_x[base + i] = x[k] + w[i] * (x[k + 1] - x[k]);
+                out_y[base + i] = y[k] + w[i] * (y[k + 1] - y[k]);
+            }
+        }
+    }
+
+    std::size_t size() const { return xs.size(); }
+    double startTime() const { return timeOf(0); }
+    double endTime() const { return timeOf(xs.size() - 1); }
+};
+
+// ʱռ x ʱͰÿ켣ÿΣΧеǼǵ
+// (ʱͰ, ) £ֲֵңѯֻѡ켣ɨȫ
+class TrajectoryIndex {
+private:
+    const std::vector<std::vector<Point2D>>* trajectories;
+    double dt;
+    double cell;
+    double bucket_duration;
+    Point2D origin{0.0, 0.0};
+    std::int64_t max_cx = 0, max_cy = 0;   // ѵǼǵ
+    std::int64_t max_bucket = 0;           // ѵǼǵʱͰ
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> entries;   // (, 켣)ȥ
+
+    // ֣ʱͰ 22 λ |  x 21 λ |  y 21 λʱȷϸ겻Խ
+    static constexpr std::int64_t kMaxCell = 0x1FFFFF;
+    static constexpr std::int64_t kMaxBucket = 0x3FFFFF;
+
+    static std::uint64_t makeKey(std::int64_t bucket, std::int64_t cx, std::int64_t cy)
+    {
+        return (static_cast<std::uint64_t>(bucket) << 42) | (static_cast<std::uint64_t>(cx) << 21) |
+               static_cast<std::uint64_t>(cy);
+    }
+
+    // Ϊꣻ NaN ͵ 2^40⸡ת
+    static std::int64_t toIndex(double f)
+    {
+        constexpr double limit = 1099511627776.0;
+        if (!(f > -limit)) return -static_cast<std::int64_t>(limit);
+        return static_cast<std::int64_t>(std::min(std::floor(f), limit));
+    }
+
+    std::int64_t cellOf(double v, double o) const { return toIndex((v - o) / cell); }
+    std::int64_t bucketOf(double t) const { return toIndex(t / bucket_duration); }
+
+    template <typename Visit>
+    void forEachInCell(std::int64_t bucket, std::int64_t cx, std::int64_t cy, Visit visit) const
+    {
+        if (bucket < 0 || cx < 0 || cy < 0 || bucket > kMaxBucket || cx > max_cx || cy > max_cy) return;
+        const std::uint64_t key = makeKey(bucket, cx, cy);
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(key, std::uint32_t(0)));
+        for (; it != entries.end() && it->first == key; ++it) visit(it->second);
+    }
+
+public:
+    TrajectoryIndex(const std::vector<std::vector<Point2D>>& trajs, double dt, double cell_size, double bucket_duration)
+        : trajectories(&trajs), dt(dt), cell(cell_size), bucket_duration(bucket_duration)
+    {
+        if (trajs.size() > 0xFFFFFFFFu) {
+            throw std::invalid_argument("켣Χ");
+        }
+        bool first = true;
+        for (const auto& tr : trajs) {
+            for (const auto& p : tr) {
+                if (first || p.x < origin.x) origin.x = p.x;
+                if (first || p.y < origin.y) origin.y = p.y;
+                first = false;
+            }
+        }
+        for (std::uint32_t id = 0; id < trajs.size(); ++id) {
+            const auto& tr = trajs[id];
+            for (std::size_t k = 0; k < tr.size(); ++k) {
+                const Point2D& a = tr[k];
+                const Point2D& b = tr[std::min(k + 1, tr.size() - 1)];
+                const std::int64_t b0 = bucketOf(k * dt), b1 = bucketOf(std::min(k + 1, tr.size() - 1) * dt);
+                const std::int64_t x0 = cellOf(std::min(a.x, b.x), origin.x), x1 = cellOf(std::max(a.x, b.x), origin.x);
+                const std::int64_t y0 = cellOf(std::min(a.y, b.y), origin.y), y1 = cellOf(std::max(a.y, b.y), origin.y);
+                if (x1 > kMaxCell || y1 > kMaxCell || b1 > kMaxBucket) {
+                    throw std::invalid_argument("켣ΧλߴʱͰ");
+                }
+                max_cx = std::max(max_cx, x1);
+                max_cy = std::max(max_cy, y1);
+                max_bucket = std::max(max_bucket, b1);
+                for (std::int64_t bk = b0; bk <= b1; ++bk)
+                    for (std::int64_t cx = x0; cx <= x1; ++cx)
+                        for (std::int64_t cy = y0; cy <= y1; ++cy) {
+                            const std::uint64_t key = makeKey(bk, cx, cy);
+                            // ͬһ켣ζͬһظֱ
+                            if (entries.empty() || entries.back().first != key || entries.back().second != id) {
+                                entries.emplace_back(key, id);
+                            }
+                        }
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    }
+
+    // 켣ʱ̵λãڲԲֵ
+    Point2D positionAt(std::size_t id, double t) const
+    {
+        const auto& tr = (*trajectories)[id];
+        const double f = std::clamp(t / dt, 0.0, static_cast<double>(tr.size() - 1));
+        const std::size_t k = std::min(static_cast<std::size_t>(f), tr.size() - 1);
+        const std::size_t k1 = std::min(k + 1, tr.size() - 1);
+        const double u = f - static_cast<double>(k);
+        return {tr[k].x + u * (tr[k1].x - tr[k].x), tr[k].y + u * (tr[k1].y - tr[k].y)};
+    }
+
+    //  [t0, t1] ھ [lo, hi] Ĺ켣ţ㾫ȷж
+    // ʱͰΧȲüѵǼǵ򣬲ѯΧٴҲֻݵĸ
+    std::vector<std::size_t> queryRegion(Point2D lo, Point2D hi, double t0, double t1) const
+    {
+        if (!(t0 <= t1) || !(lo.x <= hi.x) || !(lo.y <= hi.y)) return {};
+        const std::int64_t b0 = std::max(bucketOf(t0), std::int64_t(0)), b1 = std::min(bucketOf(t1), max_bucket);
+        const std::int64_t x0 = std::max(cellOf(lo.x, origin.x), std::int64_t(0));
+        const std::int64_t x1 = std::min(cellOf(hi.x, origin.x), max_cx);
+        const std::int64_t y0 = std::max(cellOf(lo.y, origin.y), std::int64_t(0));
+        const std::int64_t y1 = std::min(cellOf(hi.y, origin.y), max_cy);
+        if (b0 > b1 || x0 > x1 || y0 > y1) return {};
+
+        std::vector<std::uint32_t> candidates;
+        for (std::int64_t bk = b0; bk <= b1; ++bk)
+            for (std::int64_t cx = x0; cx <= x1; ++cx)
+                for (std::int64_t cy = y0; cy <= y1; ++cy)
+                    forEachInCell(bk, cx, cy, [&](std::uint32_t id) { candidates.push_back(id); });
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<std::size_t> result;
+        for (std::uint32_t id : candidates) {
+            const auto& tr = (*trajectories)[id];
+            const double last = static_cast<double>(tr.size());
+            const std::size_t k0 = static_cast<std::size_t>(std::clamp(std::ceil(t0 / dt), 0.0, last));
+            const std::size_t k1 = static_cast<std::size_t>(std::clamp(std::floor(t1 / dt) + 1.0, 0.0, last));
+            for (std::size_t k = k0; k < k1; ++k) {
+                if (tr[k].x >= lo.x && tr[k].x <= hi.x && tr[k].y >= lo.y && tr[k].y <= hi.y) {
+                    result.push_back(id);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    // ʱ t  q Ĺ켣 q ڸȦ
+    //  r Ȧ֮Ĺ켣붼 r * cellǰŲֵֹͣ
+    // ÿȦֻѵǼ [0, max_cx] x [0, max_cy] ڵĲ֣
+    // q ʱֱӴӵһཻȦʼ
+    bool nearest(Point2D q, double t, std::size_t& id, double& distance) const
+    {
+        const std::int64_t bk = bucketOf(t);
+        const std::int64_t qx = cellOf(q.x, origin.x), qy = cellOf(q.y, origin.y);
+        double best = INFINITY;
+        std::size_t best_id = 0;
+        auto visit = [&](std::uint32_t cand) {
+            const Point2D p = positionAt(cand, t);
+            const double d = std::hypot(p.x - q.x, p.y - q.y);
+            if (d < best) {
+                best = d;
+                best_id = cand;
+            }
+        };
+        // Ȧ󼴿ɽ
+        const std::int64_t min_r = std::max({-qx, qx - max_cx, -qy, qy - max_cy, std::int64_t(0)});
+        const std::int64_t max_r = std::max({qx, qy, max_cx - qx, max_cy - qy, std::int64_t(0)});
+        for (std::int64_t r = min_r; r <= max_r; ++r) {
+            const std::int64_t x_lo = std::max(qx - r, std::int64_t(0)), x_hi = std::min(qx + r, max_cx);
+            const std::int64_t y_lo = std::max(qy - r + 1, std::int64_t(0)), y_hi = std::min(qy + r - 1, max_cy);
+            for (std::int64_t cx = x_lo; cx <= x_hi; ++cx) {
+                if (qy - r >= 0) forEachInCell(bk, cx, qy - r, visit);
+                if (r > 0 && qy + r <= max_cy) forEachInCell(bk, cx, qy + r, visit);
+            }
+            for (std::int64_t cy = y_lo; cy <= y_hi; ++cy) {
+                if (qx - r >= 0) forEachInCell(bk, qx - r, cy, visit);
+                if (r > 0 && qx + r <= max_cx) forEachInCell(bk, qx + r, cy, visit);
+            }
+            if (best <= r * cell) break;
+        }
+        if (!std::isfinite(best)) return false;
+        id = best_id;
+        distance = best;
+        return true;
+    }
+};
+
+// 㣺󻺳 std::to_chars ʽ iostream ʽĿ
+class OutputBuffer {
+private:
+    std::FILE* file;
+    bool owns_file;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+
+public:
+    explicit OutputBuffer(std::FILE* f, std::size_t capacity = 1 << 20)
+        : file(f), owns_file(false), buffer(capacity) {}
+
+    explicit OutputBuffer(const std::string& path, std::size_t capacity = 1 << 20)
+        : file(std::fopen(path.c_str(), "wb")), owns_file(true), buffer(capacity)
+    {
+        if (!file) {
+            throw std::runtime_error("޷ļ: " + path);
+        }
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // ʱֻдʣݣ쳣ҪȷдɹʱӦȵ close()
+    ~OutputBuffer()
+    {
+        if (!file) return;
+        if (used > 0) std::fwrite(buffer.data(), 1, used, file);
+        if (owns_file) std::fclose(file);
+    }
+
+    // дʣݲرգļֻˢ£κһʧܶ׳쳣
+    void close()
+    {
+        if (!file) return;
+        flush();
+        std::FILE* f = file;
+        file = nullptr;
+        const bool failed = owns_file ? std::fclose(f) != 0 : (std::fflush(f) != 0 || std::ferror(f));
+        if (failed) {
+            throw std::runtime_error("дļʧ");
+        }
+    }
+
+    void flush()
+    {
+        if (used > 0 && std::fwrite(buffer.data(), 1, used, file) != used) {
+            throw std::runtime_error("дļʧ");
+        }
+        used = 0;
+    }
+
+    // ֤ٻ n ֽڿռ
+    char* reserve(std::size_t n)
+    {
+        if (buffer.size() - used < n) flush();
+        if (buffer.size() < n) buffer.resize(n);
+        return buffer.data() + used;
+    }
+
+    void write(const char* data, std::size_t n)
+    {
+        std::memcpy(reserve(n), data, n);
+        used += n;
+    }
+
+    void write(const char* text) { write(text, std::strlen(text)); }
+
+    void put(char c) { *reserve(1) = c; ++used; }
+
+    // ʽȼ std::fixed << std::setprecision(precision)
+    void fixed(double value, int precision)
+    {
+        constexpr std::size_t max_len = 64;
+        char* first = reserve(max_len);
+        auto result = std::to_chars(first, first + max_len, value, std::chars_format::fixed, precision);
+        if (result.ec != std::errc()) {
+            // ֵʱ˻ؿѧ
+            result = std::to_chars(first, first + max_len, value);
+        }
+        used += static_cast<std::size_t>(result.ptr - first);
+    }
+};
+
+enum class OutputFormat {
+    Text,     // ԭепɶʽ
+    Csv,      // һһ켣Ϊ
+    Binary,   // նдʽ
+    Mmap,     //  Binary ֣ͬڴӳдֱ mmap ȡ
+    Summary   // ֻӡժҪ
+};
+
+struct NamedTrajectory {
+    const char* name;
+    const std::vector<Point2D>* points;
+};
+
+// дļͷ֮Ϊÿ켣 x к y Уdouble
+// ͷΪ 8 ֽڶ룬ӳпֱӰ double 
+struct TrajectoryFileHeader {
+    char magic[4];           // "TRJ1"
+    std::uint32_t columns;   //  = 켣 * 2
+    std::uint64_t samples;   // ÿв
+    double dt;               // 룩
+};
+
+void writeText(OutputBuffer& out, const char* title, const std::vector<Point2D>& points, double dt)
+{
+    out.write("\n--- ");
+    out.write(title);
+    out.write(" ---\n");
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        out.write("t=");
+        out.fixed(i * dt, 3);
+        out.write("s: (");
+        out.fixed(points[i].x, 4);
+        out.write(", ");
+        out.fixed(points[i].y, 4);
+        out.write(")\n");
+    }
+}
+
+void writeCsv(OutputBuffer& out, const std::vector<NamedTrajectory>& tracks, double dt)
+{
+    out.write("t");
+    for (const auto& track : tracks) {
+        out.put(',');
+        out.write(track.name);
+        out.write("_x,");
+        out.write(track.name);
+        out.write("_y");
+    }
+    out.put('\n');
+
+    const std::size_t samples = tracks.empty() ? 0 : tracks.front().points->size();
+    for (std::size_t i = 0; i < samples; ++i) {
+        out.fixed(i * dt, 3);
+        for (const auto& track : tracks) {
+            const Point2D& p = (*track.points)[i];
+            out.put(',');
+            out.fixed(p.x, 6);
+            out.put(',');
+            out.fixed(p.y, 6);
+        }
+        out.put('\n');
+    }
+}
+
+TrajectoryFileHeader makeHeader(const std::vector<NamedTrajectory>& tracks, double dt)
+{
+    TrajectoryFileHeader header{{'T', 'R', 'J', '1'}, 0, 0, dt};
+    header.columns = static_cast<std::uint32_t>(tracks.size() * 2);
+    header.samples = tracks.empty() ? 0 : tracks.front().points->size();
+    return header;
+}
+
+// ѵ column У켣 column/2  x  y dst
+void gatherColumn(const std::vector<NamedTrajectory>& tracks, std::size_t column, double* dst)
+{
+    const auto& points = *tracks[column / 2].points;
+    const bool is_y = (column % 2) != 0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        dst[i] = is_y ? points[i].y : points[i].x;
+    }
+}
+
+void writeBinary(OutputBuffer& out, const std::vector<NamedTrajectory>& tracks, double dt)
+{
+    const TrajectoryFileHeader header = makeHeader(tracks, dt);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<double> column(header.samples);
+    for (std::size_t c = 0; c < header.columns; ++c) {
+        gatherColumn(tracks, c, column.data());
+        out.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(double));
+    }
+}
+
+void writeMmap(const std::string& path, const std::vector<NamedTrajectory>& tracks, double dt)
+{
+#ifdef TRAJ_HAVE_MMAP
+    const TrajectoryFileHeader header = makeHeader(tracks, dt);
+    const std::size_t size = sizeof(header) + header.columns * header.samples * sizeof(double);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("޷ļ: " + path);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        throw std::runtime_error("޷ļС: " + path);
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("ڴӳʧ: " + path);
+    }
+
+    char* base = static_cast<char*>(mapped);
+    std::memcpy(base, &header, sizeof(header));
+    double* columns = reinterpret_cast<double*>(base + sizeof(header));
+    for (std::size_t c = 0; c < header.columns; ++c) {
+        gatherColumn(tracks, c, columns + c * header.samples);
+    }
+    ::munmap(mapped, size);
+#else
+    // ֧ mmap ƽ̨ͬ˳д
+    OutputBuffer out(path);
+    writeBinary(out, tracks, dt);
+    out.close();
+#endif
+}
+
+void writeSummary(OutputBuffer& out, const std::vector<NamedTrajectory>& tracks, double dt)
+{
+    for (const auto& track : tracks) {
+        const auto& points = *track.points;
+        out.write(track.name);
+        out.write(": =");
+        out.fixed(static_cast<double>(points.size()), 0);
+        if (!points.empty()) {
+            out.write(", յ t=");
+            out.fixed((points.size() - 1) * dt, 3);
+            out.write("s: (");
+            out.fixed(points.back().x, 4);
+            out.write(", ");
+            out.fixed(points.back().y, 4);
+            out.put(')');
+        }
+        out.put('\n');
+    }
+}
+
+void writeErrorSummary(OutputBuffer& out, const char* name, const ErrorStatistics& stats)
+{
+    out.write(name);
+    out.write(": RMSE=");
+    out.fixed(stats.rmse(), 4);
+    out.write(", =");
+    out.fixed(stats.maxError(), 4);
+    out.write(", ƫ=(");
+    out.fixed(stats.bias().x, 4);
+    out.write(", ");
+    out.fixed(stats.bias().y, 4);
+    out.put(')');
+    if (stats.nees().count() > 0) {
+        out.write(", NEES ֵ=");
+        out.fixed(stats.nees().mean(), 3);
+    }
+    if (stats.nis().count() > 0) {
+        out.write(", NIS ֵ=");
+        out.fixed(stats.nis().mean(), 3);
+    }
+    out.put('\n');
+}
+
+//  64 λƫƶλWindows  long ֻ 32 λstd::fseek  2 GiB ʧ
+inline bool seekTo(std::FILE* f, std::uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(f, static_cast<__int64>(offset), SEEK_SET) == 0;
+#elif defined(TRAJ_HAVE_MMAP)
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#else
+    return offset <= static_cast<std::uint64_t>(LONG_MAX) && std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0;
+#endif
+}
+
+//  TRJ1 ļе track 켣 RTS ƽڳڴĳ켣
+// ۲ⰴ룬ǰ˲˳дʱļƽʱ鵹أ
+// дֻһ켣 TRJ1 ļڴռֻСй
+void smoothTrajectoryFile(const std::string& input_path, std::size_t track, const std::string& output_path,
+                          double process_noise_stddev, double measurement_noise_stddev,
+                          std::size_t block = 1 << 16)
+{
+    std::FILE* in = std::fopen(input_path.c_str(), "rb");
+    if (!in) {
+        throw std::runtime_error("޷ļ: " + input_path);
+    }
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> in_guard(in, std::fclose);
+
+    TrajectoryFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1 || std::memcmp(header.magic, "TRJ1", 4) != 0) {
+        throw std::runtime_error("ЧĹ켣ļ: " + input_path);
+    }
+    if (2 * track + 1 >= header.columns) {
+        throw std::out_of_range("켣ųļΧ");
+    }
+    const std::size_t n = header.samples;
+    const double dt = header.dt;
+    auto columnOffset = [&](std::size_t column, std::size_t i) {
+        return sizeof(header) + (std::uint64_t(column) * n + i) * sizeof(double);
+    };
+    auto readColumn = [&](std::size_t column, std::size_t i, std::size_t count, double* dst) {
+        if (!seekTo(in, columnOffset(column, i)) ||
+            std::fread(dst, sizeof(double), count, in) != count) {
+            throw std::runtime_error("ȡ켣ļʧ: " + input_path);
+        }
+    };
+
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> tmp(std::tmpfile(), std::fclose);
+    if (!tmp) {
+        throw std::runtime_error("޷ʱļ");
+    }
+
+    // ǰ˲
+    std::vector<double> xs(block), ys(block);
+    std::vector<FilteredStep> steps(block);
+    KalmanFilterCV filter(process_noise_stddev, measurement_noise_stddev);
+    for (std::size_t begin = 0; begin < n; begin += block) {
+        const std::size_t count = std::min(block, n - begin);
+        readColumn(2 * track, begin, count, xs.data());
+        readColumn(2 * track + 1, begin, count, ys.data());
+        for (std::size_t k = 0; k < count; ++k) {
+            const Point2D z{xs[k], ys[k]};
+            if (begin + k == 0) {
+                filter.init(z, {0.0, 0.0}, measurement_noise_stddev * measurement_noise_stddev, 100.0);
+            } else {
+                filter.predict(dt);
+                filter.update(z);
+            }
+            steps[k] = {filter.state(), filter.covariance()};
+        }
+        if (std::fwrite(steps.data(), sizeof(FilteredStep), count, tmp.get()) != count) {
+            throw std::runtime_error("дʱļʧ");
+        }
+    }
+
+    std::FILE* out = std::fopen(output_path.c_str(), "wb+");
+    if (!out) {
+        throw std::runtime_error("޷ļ: " + output_path);
+    }
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> out_guard(out, std::fclose);
+    const TrajectoryFileHeader out_header{{'T', 'R', 'J', '1'}, 2, header.samples, dt};
+    if (std::fwrite(&out_header, sizeof(out_header), 1, out) != 1) {
+        throw std::runtime_error("дļʧ: " + output_path);
+    }
+
+    // ƽβͷ
+    const Mat4 F = transitionCV(dt);
+    const Mat4 Q = processNoiseCV(dt, process_noise_stddev);
+    FilteredStep next{};
+    std::size_t end = n;
+    while (end > 0) {
+        const std::size_t begin = end > block ? end - block : 0;
+        const std::size_t count = end - begin;
+        if (!seekTo(tmp.get(), std::uint64_t(begin) * sizeof(FilteredStep)) ||
+            std::fread(steps.data(), sizeof(FilteredStep), count, tmp.get()) != count) {
+            throw std::runtime_error("ȡʱļʧ");
+        }
+        for (std::size_t k = count; k-- > 0;) {
+            next = (begin + k == n - 1) ? steps[k] : smoothStep(steps[k], next, F, Q);
+            xs[k] = next.x(0, 0);
+            ys[k] = next.x(1, 0);
+        }
+        const std::uint64_t x_offset = sizeof(out_header) + std::uint64_t(begin) * sizeof(double);
+        const std::uint64_t y_offset = sizeof(out_header) + (std::uint64_t(n) + begin) * sizeof(double);
+        if (!seekTo(out, x_offset) || std::fwrite(xs.data(), sizeof(double), count, out) != count ||
+            !seekTo(out, y_offset) || std::fwrite(ys.data(), sizeof(double), count, out) != count) {
+            throw std::runtime_error("дļʧ: " + output_path);
+        }
+        end = begin;
+    }
+    if (std::fclose(out_guard.release()) != 0) {
+        throw std::runtime_error("дļʧ: " + output_path);
+    }
+}
+
+// ʵʱģʽ dt Ӧǽʷʹ
+// ߵζУΪ 2 ݣhead/tail ִͬ
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, " 2 ");
+
+private:
+    std::array<T, Capacity> buffer;
+    alignas(64) std::atomic<std::size_t> head{0};   // ߶ȡλ
+    alignas(64) std::atomic<std::size_t> tail{0};   // дλ
+
+public:
+    bool push(const T& item)
+    {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        buffer[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = buffer[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Խֹʱ sleep_until ֹʱǰ spin_marginæȵֹʱ䣬
+// ֹʱ䰴 start + k * period 㣬򵥴ӳٶۻƯ
+class DeadlinePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::time_point start;
+    Clock::duration period;
+    Clock::duration spin_margin;
+    std::uint64_t tick = 0;
+
+public:
+    DeadlinePacer(double period_seconds, double spin_margin_seconds = 200e-6)
+        : start(Clock::now()),
+          period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period_seconds))),
+          spin_margin(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spin_margin_seconds))) {}
+
+    // ȴһֹʱ䣬ʵʻʱԽֹʱӳ٣룩
+    double waitNext()
+    {
+        const Clock::time_point deadline = start + period * static_cast<Clock::rep>(++tick);
+        std::this_thread::sleep_until(deadline - spin_margin);
+        Clock::time_point now = Clock::now();
+        while (now < deadline) now = Clock::now();
+        return std::chrono::duration<double>(now - deadline).count();
+    }
+};
+
+// Ķͳƣӳٳ miss_threshold Ϊֹʱ䣻
+// ֱͼ΢ȡͰ[0,1), [1,2), [2,4), ... һͰΪ
+struct PacingReport {
+    static constexpr std::size_t bins = 18;
+
+    std::uint64_t samples = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t queue_full = 0;
+    RunningStats lateness_us;
+    std::array<std::uint64_t, bins> histogram{};
+
+    void record(double lateness_seconds, double miss_threshold_seconds)
+    {
+        ++samples;
+        if (lateness_seconds > miss_threshold_seconds) ++misses;
+        const double us = lateness_seconds * 1e6;
+        lateness_us.add(us);
+        std::size_t bin = 0;
+        for (double edge = 1.0; bin + 1 < bins && us >= edge; edge *= 2.0) ++bin;
+        ++histogram[bin];
+    }
+};
+
+struct StampedSample {
+    std::uint64_t index;
+    double time;
+    Point2D observed;
+};
+
+// ̰߳ķ۲⣬ߣ̣߳ÿ˲ʵʱ
+PacingReport runRealtime(const std::vector<Point2D>& observed_positions, double dt,
+                         double process_noise_stddev, double measurement_noise_stddev,
+                         std::vector<Point2D>* estimates = nullptr)
+{
+    auto queue = std::make_unique<SpscQueue<StampedSample, 1024>>();
+    std::atomic<bool> done{false};
+    PacingReport report;
+
+    std::thread producer([&]() {
+        DeadlinePacer pacer(dt);
+        for (std::size_t i = 0; i < observed_positions.size(); ++i) {
+            report.record(pacer.waitNext(), 0.5 * dt);
+            if (!queue->push(StampedSample{i, i * dt, observed_positions[i]})) ++report.queue_full;
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    KalmanFilterCV filter(process_noise_stddev, measurement_noise_stddev);
+    bool initialized = false;
+    auto consume = [&](const StampedSample& sample) {
+        if (!initialized) {
+            filter.init(sample.observed, {0.0, 0.0}, measurement_noise_stddev * measurement_noise_stddev, 100.0);
+            initialized = true;
+        } else {
+            filter.predict(dt);
+            filter.update(sample.observed);
+        }
+        if (estimates) estimates->push_back(filter.position());
+    };
+
+    StampedSample sample;
+    for (;;) {
+        if (queue->pop(sample)) {
+            consume(sample);
+        } else if (done.load(std::memory_order_acquire)) {
+            // ߽ȡ
+            while (queue->pop(sample)) consume(sample);
+            break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    return report;
+}
+
+void writePacingReport(OutputBuffer& out, const PacingReport& report, double dt)
+{
+    out.write("\n--- ʵʱͳ ---\n=");
+    out.fixed(static_cast<double>(report.samples), 0);
+    out.write(", ֹʱ=");
+    out.fixed(static_cast<double>(report.misses), 0);
+    out.write(" (ֵ ");
+    out.fixed(0.5 * dt * 1e3, 1);
+    out.write("ms), =");
+    out.fixed(static_cast<double>(report.queue_full), 0);
+    out.write("\nӳ(us): ֵ=");
+    out.fixed(report.lateness_us.mean(), 2);
+    out.write(", ׼=");
+    out.fixed(report.lateness_us.stddev(), 2);
+    out.write(", =");
+    out.fixed(report.lateness_us.count() ? report.lateness_us.max() : 0.0, 2);
+    out.put('\n');
+    double lo = 0.0, hi = 1.0;
+    for (std::size_t b = 0; b < PacingReport::bins; ++b) {
+        if (report.histogram[b] > 0) {
+            out.write("  [");
+            out.fixed(lo, 0);
+            if (b + 1 < PacingReport::bins) {
+                out.write(", ");
+                out.fixed(hi, 0);
+                out.write(") us: ");
+            } else {
+                out.write(", +inf) us: ");
+            }
+            out.fixed(static_cast<double>(report.histogram[b]), 0);
+            out.put('\n');
+        }
+        lo = hi;
+        hi *= 2.0;
+    }
+}
+
+// ǽɨ裺ʱdtٶȡˮƽӵУ
+// ɹȡִ̳߳Уֵ TruthCache 
+// ÿһ׷дļɵĸдһŻܱ
+struct SweepGrid {
+    std::vector<double> durations{5.0};
+    std::vector<double> dts{0.01};
+    std::vector<Point2D> velocities{{2.0, 3.0}};
+    std::vector<double> noises{0.5};
+    unsigned seeds = 1;
+};
+
+struct SweepCell {
+    std::size_t index;
+    double duration, dt;
+    Point2D velocity;
+    double noise;
+    unsigned seed;
+    double observed_rmse = 0.0, estimated_rmse = 0.0, nees = 0.0;
+    bool done = false;
+};
+
+std::vector<SweepCell> enumerateCells(const SweepGrid& grid)
+{
+    std::vector<SweepCell> cells;
+    for (double duration : grid.durations)
+        for (double dt : grid.dts)
+            for (const Point2D& v : grid.velocities)
+                for (double noise : grid.noises)
+                    for (unsigned seed = 0; seed < grid.seeds; ++seed)
+                        cells.push_back(SweepCell{cells.size(), duration, dt, v, noise, seed});
+    return cells;
+}
+
+// Ĳ "duration,dt,vx,vy,noise,seed" CSV еĶӦֶͬ
+// 㰴üƥ䣬ɾɵĸܸ
+std::string cellKey(const SweepCell& c)
+{
+    std::string key;
+    char text[64];
+    for (double value : {c.duration, c.dt, c.velocity.x, c.velocity.y, c.noise}) {
+        auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 6);
+        if (result.ec != std::errc()) result = std::to_chars(text, text + sizeof(text), value);
+        key.append(text, result.ptr);
+        key.push_back(',');
+    }
+    key += std::to_string(c.seed);
+    return key;
+}
+
+// ÿɲöеλ޹
+unsigned cellSeed(const SweepCell& c)
+{
+    const std::string key = cellKey(c);
+    std::seed_seq seq(key.begin(), key.end());
+    unsigned seed = 0;
+    seq.generate(&seed, &seed + 1);
+    return seed;
+}
+
+void writeCellRow(OutputBuffer& out, const SweepCell& c)
+{
+    out.fixed(static_cast<double>(c.index), 0);
+    out.put(',');
+    out.write(cellKey(c).c_str());
+    for (double value : {c.observed_rmse, c.estimated_rmse, c.nees}) {
+        out.put(',');
+        out.fixed(value, 6);
+    }
+    out.put('\n');
+}
+
+// ȡ㣺еĲ뵱ǰĳͬΪøɡ
+// ļѹΪÿֻһУظʱ
+// ڵǰҲԭʱԿɸ
+void loadSweepCheckpoint(const std::string& path, std::vector<SweepCell>& cells)
+{
+    std::ifstream in(path);
+    if (!in) return;
+
+    std::map<std::string, SweepCell*> by_key;
+    for (auto& c : cells) by_key[cellKey(c)] = &c;
+
+    std::map<std::string, std::string> rows;   //  -> һ
+    std::string line;
+    while (std::getline(in, line)) {
+        // иʽindex,<6 ֶ>,<3 ֶ>
+        std::size_t commas[9];
+        std::size_t found = 0;
+        for (std::size_t pos = line.find(','); pos != std::string::npos && found < 9; pos = line.find(',', pos + 1))
+            commas[found++] = pos;
+        if (found != 9 || line.find(',', commas[8] + 1) != std::string::npos) continue;
+        const std::string key = line.substr(commas[0] + 1, commas[6] - commas[0] - 1);
+        const std::string results = line.substr(commas[6] + 1);
+
+        double f[3];
+        const char* p = results.c_str();
+        char* end = nullptr;
+        int n = 0;
+        for (; n < 3; ++n) {
+            f[n] = std::strtod(p, &end);
+            if (end == p || (*end != ',' && *end != '\0')) break;
+            p = end + 1;
+        }
+        if (n != 3) continue;
+        rows[key] = line;
+
+        auto it = by_key.find(key);
+        if (it == by_key.end()) continue;
+        SweepCell& c = *it->second;
+        c.observed_rmse = f[0];
+        c.estimated_rmse = f[1];
+        c.nees = f[2];
+        c.done = true;
+    }
+    in.close();
+
+    const std::string compact_path = path + ".tmp";
+    {
+        OutputBuffer out(compact_path);
+        for (const auto& row : rows) {
+            out.write(row.second.c_str());
+            out.put('\n');
+        }
+        out.close();
+    }
+    std::remove(path.c_str());
+    if (std::rename(compact_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("޷¼ļ: " + path);
+    }
+}
+
+void runSweep(const SweepGrid& grid, const std::string& results_path, const std::string& checkpoint_path,
+              double filter_process_noise_stddev, unsigned num_threads = 0)
+{
+    std::vector<SweepCell> cells = enumerateCells(grid);
+    loadSweepCheckpoint(checkpoint_path, cells);
+
+    std::size_t already = 0;
+    for (const auto& c : cells) already += c.done;
+    std::cout << "ɨ蹲 " << cells.size() << " 񣬼 " << already << " " << std::endl;
+
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> checkpoint(std::fopen(checkpoint_path.c_str(), "ab"), std::fclose);
+    if (!checkpoint) {
+        throw std::runtime_error("޷򿪼ļ: " + checkpoint_path);
+    }
+    std::mutex checkpoint_mutex;
+    TruthCache truths;
+
+    std::vector<std::function<void()>> tasks;
+    for (auto& cell : cells) {
+        if (cell.done) continue;
+        tasks.push_back([&, c = &cell]() {
+            TruthScenario scenario;
+            scenario.total_time = c->duration;
+            scenario.dt = c->dt;
+            scenario.velocity = c->velocity;
+            const SharedTrajectory truth = truths.get(scenario);
+
+            PseudoRandomNormal normal(cellSeed(*c));
+            const std::vector<Point2D> observed = addMeasurementNoiseWith(*truth, c->noise, normal);
+            const ErrorStatistics est = evaluateFilter(*truth, observed, c->dt, filter_process_noise_stddev, c->noise);
+            c->observed_rmse = compareTrajectories(observed, *truth).rmse();
+            c->estimated_rmse = est.rmse();
+            c->nees = est.nees().mean();
+            c->done = true;
+
+            std::lock_guard<std::mutex> lock(checkpoint_mutex);
+            {
+                OutputBuffer out(checkpoint.get(), 256);
+                writeCellRow(out, *c);
+                out.close();
+            }
+        });
+    }
+    WorkStealingPool(num_threads).run(std::move(tasks));
+
+    OutputBuffer out(results_path);
+    out.write("index,duration,dt,vx,vy,noise,seed,observed_rmse,estimated_rmse,nees\n");
+    for (const auto& c : cells) writeCellRow(out, c);
+    out.close();
+    std::cout << "ܽд " << results_path << std::endl;
+}
+
+// ŷֵָбٶд vx:vy
+std::vector<double> parseList(const std::string& text)
+{
+    std::vector<double> values;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        const std::size_t comma = std::min(text.find(',', start), text.size());
+        const std::string item = text.substr(start, comma - start);
+        char* end = nullptr;
+        const double v = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0') {
+            throw std::invalid_argument("޷ֵ: " + item);
+        }
+        values.push_back(v);
+        start = comma + 1;
+    }
+    return values;
+}
+
+std::vector<Point2D> parseVelocities(const std::string& text)
+{
+    std::vector<Point2D> values;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        const std::size_t comma = std::min(text.find(',', start), text.size());
+        const std::string item = text.substr(start, comma - start);
+        const std::size_t colon = item.find(':');
+        if (colon == std::string::npos) {
+            throw std::invalid_argument("ٶӦд vx:vy: " + item);
+        }
+        const std::vector<double> xy = parseList(item.substr(0, colon) + "," + item.substr(colon + 1));
+        values.push_back({xy[0], xy[1]});
+        start = comma + 1;
+    }
+    return values;
+}
+
+// Ǹ߳
+unsigned parseCount(const std::string& text, const char* name)
+{
+    const std::vector<double> values = parseList(text);
+    const double v = values.front();
+    if (values.size() != 1 || !(v >= 0.0) || v > static_cast<double>(UINT_MAX) || v != std::floor(v)) {
+        throw std::invalid_argument(std::string(name) + " ӦΪǸ: " + text);
+    }
+    return static_cast<unsigned>(v);
+}
+
+// ɨdt ΪʱǸҲ int Χ
+void validateGrid(const SweepGrid& grid)
+{
+    for (double dt : grid.dts) {
+        if (!(dt > 0.0) || !std::isfinite(dt)) {
+            throw std::invalid_argument("dt Ϊ");
+        }
+    }
+    for (double duration : grid.durations) {
+        if (!(duration >= 0.0) || !std::isfinite(duration)) {
+            throw std::invalid_argument("ʱΪǸ");
+        }
+        for (double dt : grid.dts) {
+            if (duration / dt > static_cast<double>(INT_MAX) - 1.0) {
+                throw std::invalid_argument("ʱ dt ֮ȹ");
+            }
+        }
+    }
+    for (double noise : grid.noises) {
+        if (!(noise >= 0.0) || !std::isfinite(noise)) {
+            throw std::invalid_argument("׼ΪǸ");
+        }
+    }
+    for (const Point2D& v : grid.velocities) {
+        if (!std::isfinite(v.x) || !std::isfinite(v.y)) {
+            throw std::invalid_argument("ٶȱΪֵ");
+        }
+    }
+}
+
+// ѡ
+struct Options {
+    bool parallel_scan = false;                 // --scan3 ʹòǰ׺ͻ
+    bool float_mode = false;                    // --float3 ʹõں
+    OutputFormat format = OutputFormat::Text;   // --format=text|csv|bin|mmap|none
+    std::string output_path;                    // --out=·csv ȱʡΪ׼
+    bool realtime = false;                      // --realtimeǽӽķ۲Ⲣͳƶ
+    double total_time = -1.0;                   // --time=룬ʱٴӱ׼ȡ
+    bool sweep = false;                         // --sweepǽɨ
+    SweepGrid grid;                             // --durations= --dts= --velocities= --noises= --seeds=
+    std::string checkpoint_path = "sweep_checkpoint.csv";   // --checkpoint=·
+    unsigned threads = 0;                       // --threads=N0 ʾӲ߳
+};
+
+Options parseOptions(int argc, char* argv[])
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--scan") {
+            opt.parallel_scan = true;
+        } else if (arg == "--float") {
+            opt.float_mode = true;
+        } else if (arg == "--realtime") {
+            opt.realtime = true;
+        } else if (arg.rfind("--format=", 0) == 0) {
+            const std::string value = arg.substr(9);
+            if (value == "text") opt.format = OutputFormat::Text;
+            else if (value == "csv") opt.format = OutputFormat::Csv;
+            else if (value == "bin") opt.format = OutputFormat::Binary;
+            else if (value == "mmap") opt.format = OutputFormat::Mmap;
+            else if (value == "none") opt.format = OutputFormat::Summary;
+            else throw std::invalid_argument("δ֪ʽ: " + value);
+        } else if (arg.rfind("--out=", 0) == 0) {
+            opt.output_path = arg.substr(6);
+        } else if (arg.rfind("--time=", 0) == 0) {
+            opt.total_time = parseList(arg.substr(7)).at(0);
+            if (!(opt.total_time >= 0.0) || !std::isfinite(opt.total_time)) {
+                throw std::invalid_argument("--time ΪǸ");
+            }
+        } else if (arg == "--sweep") {
+            opt.sweep = true;
+        } else if (arg.rfind("--durations=", 0) == 0) {
+            opt.grid.durations = parseList(arg.substr(12));
+        } else if (arg.rfind("--dts=", 0) == 0) {
+            opt.grid.dts = parseList(arg.substr(6));
+        } else if (arg.rfind("--velocities=", 0) == 0) {
+            opt.grid.velocities = parseVelocities(arg.substr(13));
+        } else if (arg.rfind("--noises=", 0) == 0) {
+            opt.grid.noises = parseList(arg.substr(9));
+        } else if (arg.rfind("--seeds=", 0) == 0) {
+            opt.grid.seeds = parseCount(arg.substr(8), "--seeds");
+        } else if (arg.rfind("--checkpoint=", 0) == 0) {
+            opt.checkpoint_path = arg.substr(13);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            opt.threads = parseCount(arg.substr(10), "--threads");
+        } else {
+            throw std::invalid_argument("δ֪Ĳ: " + arg);
+        }
+    }
+    validateGrid(opt.grid);
+    if ((opt.format == OutputFormat::Binary || opt.format == OutputFormat::Mmap) && opt.output_path.empty()) {
+        opt.output_path = "trajectory.bin";
+    }
+    if (opt.sweep && opt.output_path.empty()) {
+        opt.output_path = "sweep_results.csv";
+    }
+    return opt;
+}
+
+void run(const Options& opt)
 {
     // ģʱ t룩
-    double total_time;
-    std::cout << "ģʱ䣨λ룬鲻5룩";
-    std::cin >> total_time;
+    double total_time = opt.total_time;
+    if (total_time < 0.0) {
+        std::cout << "ģʱ䣨λ룬鲻5룩";
+        std::cin >> total_time;
+        std::cout << std::flush;
+    }
 
     // ʱͳٶȶ
     constexpr double dt = 0.01;          // 100fpsÿ֡10
@@ -88,34 +4112,96 @@ int main()
 
     // --- 1: 㶨ٶֵλ ---
     auto true_positions = simulateConstantVelocity(total_time, dt, initial_pos, initial_velocity);
-    std::cout << "\n--- 1ʵλã㶨ٶȣ ---\n";
-    for (size_t i = 0; i < true_positions.size(); ++i) {
-        std::cout << "t=" << std::fixed << std::setprecision(3) << i * dt
-                  << "s: (" << std::fixed << std::setprecision(4) << true_positions[i].x
-                  << ", " << true_positions[i].y << ")\n";
-    }
 
     // --- 2: ӲĹ۲λ ---
     constexpr double measurement_noise_stddev = 0.5;
     auto observed_positions = addMeasurementNoise(true_positions, measurement_noise_stddev);
-    std::cout << "\n--- 2۲λ ---\n";
-    for (size_t i = 0; i < observed_positions.size(); ++i) {
-        std::cout << "t=" << std::fixed << std::setprecision(3) << i * dt
-                  << "s: (" << std::fixed << std::setprecision(4) << observed_positions[i].x
-                  << ", " << observed_positions[i].y << ")\n";
-    }
 
     // --- 3: ٶģ ---
     constexpr double process_noise_stddev = 0.1;  // ׼ɸ
-    auto process_noise_positions =
-        simulateWithProcessNoise(total_time, dt, initial_pos, initial_velocity, process_noise_stddev);
+    auto process_noise_positions = opt.parallel_scan
+        ? simulateWithProcessNoiseScan(total_time, dt, initial_pos, initial_velocity, process_noise_stddev)
+        : opt.float_mode
+        ? simulateWithProcessNoiseFloat(total_time, dt, initial_pos, initial_velocity, process_noise_stddev)
+        : simulateWithProcessNoise(total_time, dt, initial_pos, initial_velocity, process_noise_stddev);
+
+    // --- 4: ˲ ---
+    constexpr double filter_process_noise_stddev = 0.01;  // ֵΪ٣˲ֻСĹ
+    auto estimated_positions =
+        filterTrajectory(observed_positions, dt, filter_process_noise_stddev, measurement_noise_stddev);
+
+    if (opt.realtime) {
+        const PacingReport report =
+            runRealtime(observed_positions, dt, filter_process_noise_stddev, measurement_noise_stddev);
+        OutputBuffer out(stdout);
+        writePacingReport(out, report, dt);
+        out.close();
+    }
+
+    const std::vector<NamedTrajectory> tracks{
+        {"true", &true_positions},
+        {"observed", &observed_positions},
+        {"process", &process_noise_positions},
+        {"estimated", &estimated_positions},
+    };
 
-    std::cout << "\n--- 3ٶȵʵλ ---\n";
-    for (size_t i = 0; i < process_noise_positions.size(); ++i) {
-        std::cout << "t=" << std::fixed << std::setprecision(3) << i * dt
-                  << "s: (" << std::fixed << std::setprecision(4) << process_noise_positions[i].x
-                  << ", " << process_noise_positions[i].y << ")\n";
+    switch (opt.format) {
+    case OutputFormat::Text: {
+        OutputBuffer out(stdout);
+        writeText(out, "1ʵλã㶨ٶȣ", true_positions, dt);
+        writeText(out, "2۲λ", observed_positions, dt);
+        writeText(out, "3ٶȵʵλ", process_noise_positions, dt);
+        writeText(out, "4˲λ", estimated_positions, dt);
+        out.close();
+        break;
+    }
+    case OutputFormat::Csv:
+        if (opt.output_path.empty()) {
+            OutputBuffer out(stdout);
+            writeCsv(out, tracks, dt);
+            out.close();
+        } else {
+            OutputBuffer out(opt.output_path);
+            writeCsv(out, tracks, dt);
+            out.close();
+        }
+        break;
+    case OutputFormat::Binary: {
+        OutputBuffer out(opt.output_path);
+        writeBinary(out, tracks, dt);
+        out.close();
+        break;
+    }
+    case OutputFormat::Mmap:
+        writeMmap(opt.output_path, tracks, dt);
+        break;
+    case OutputFormat::Summary: {
+        OutputBuffer out(stdout);
+        out.put('\n');
+        writeSummary(out, tracks, dt);
+        writeErrorSummary(out, "observed ", compareTrajectories(observed_positions, true_positions));
+        writeErrorSummary(out, "estimated ",
+                          evaluateFilter(true_positions, observed_positions, dt,
+                                         filter_process_noise_stddev, measurement_noise_stddev));
+        out.close();
+        break;
     }
+    }
+}
 
+int main(int argc, char* argv[])
+{
+    try {
+        const Options opt = parseOptions(argc, argv);
+        if (opt.sweep) {
+            constexpr double filter_process_noise_stddev = 0.01;
+            runSweep(opt.grid, opt.output_path, opt.checkpoint_path, filter_process_noise_stddev, opt.threads);
+        } else {
+            run(opt);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << ": " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }